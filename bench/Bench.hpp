@@ -0,0 +1,84 @@
+#pragma once
+
+/**
+ * Micro-benchmark Harness
+ * =======================
+ * Each benchmark is a named, parameterized case whose `setup` builds whatever it
+ * needs (engine, oscillator, ...) and returns a runner that processes a given
+ * number of sample frames. The runner in `main.cpp` times repeated runs and
+ * reports per-sample cost statistics as JSON.
+ *
+ * Benchmarks are registered per area in `<Area>Bench.cpp` through a
+ * `register<Area>Benchmarks(Registry &)` function that `main.cpp` calls.
+ */
+
+#include <stddef.h>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../src/core2/engine/Engine.hpp"
+
+namespace phnq
+{
+  namespace bench
+  {
+    const float SAMPLE_RATE = 48000.f;
+    const size_t BLOCK_SIZE = 48;
+
+    struct Param
+    {
+      std::string name;
+      double value;
+    };
+
+    typedef std::function<void(size_t numFrames)> Runner;
+
+    struct Benchmark
+    {
+      std::string name;
+      std::vector<Param> params;
+      std::function<Runner()> setup;
+    };
+
+    typedef std::vector<Benchmark> Registry;
+
+    extern volatile float sink; // Defined in main.cpp.
+
+    /**
+     * @brief Keep the compiler from discarding benchmarked work whose result is
+     * otherwise unused. Call once per run with an accumulated value, not per sample.
+     */
+    inline void doNotOptimize(float value)
+    {
+      sink = value;
+    }
+
+    const size_t MAX_AUDIO_OUTS = 2;
+
+    /**
+     * @brief The block loop shared by engine benchmarks: process `numFrames`
+     * frames through `engine` in `BLOCK_SIZE` blocks, as an adapter would. The
+     * engine must have no audio inputs and at most `MAX_AUDIO_OUTS` outputs.
+     */
+    inline void runBlocks(phnq::engine::Engine *engine, size_t numFrames)
+    {
+      const phnq::engine::FrameInfo frameInfo = {SAMPLE_RATE, 1.f / SAMPLE_RATE};
+      float blocks[MAX_AUDIO_OUTS][BLOCK_SIZE];
+      float *const audioOutBlocks[] = {blocks[0], blocks[1]};
+      size_t numAudioOuts = engine->getAudioOuts().size();
+      float sum = 0.f;
+      for (size_t frame = 0; frame < numFrames; frame += BLOCK_SIZE)
+      {
+        size_t numBlockFrames = std::min(BLOCK_SIZE, numFrames - frame);
+        engine->doProcessBlock(frameInfo, numBlockFrames, NULL, audioOutBlocks);
+        for (size_t i = 0; i < numAudioOuts; i++)
+        {
+          sum += blocks[i][0];
+        }
+      }
+      doNotOptimize(sum);
+    }
+  }
+}
@@ -0,0 +1,61 @@
+#include "../src/modules/ChordSeq/ChordSeq.cpp"
+#include "Bench.hpp"
+
+using namespace phnq::bench;
+
+const FrameInfo FRAME_INFO = {SAMPLE_RATE, 1.f / SAMPLE_RATE};
+
+/**
+ * @brief Build a ChordSeq whose only chord has `numNotes` notes.
+ */
+static std::shared_ptr<ChordSeq> createChordSeq(size_t numNotes, float shape, float detune)
+{
+  std::shared_ptr<ChordSeq> chordSeq(new ChordSeq());
+  chordSeq->doProcess(FRAME_INFO);
+
+  chordSeq->chordStore.clear();
+  chordSeq->chordIndex = 0;
+  for (size_t i = 0; i < numNotes; i++)
+  {
+    // Stack major thirds upwards from C3.
+    chordSeq->addNoteToCurrentChord(0.2f + i * 4.f / 120.f);
+  }
+
+  chordSeq->shapeParam->setValue(shape);
+  chordSeq->detuneParam->setValue(detune);
+  return chordSeq;
+}
+
+static Benchmark processBenchmark(size_t numNotes, float shape, float detune)
+{
+  return {"ChordSeq/process",
+          {{"notes", (double)numNotes}, {"shape", shape}, {"detune", detune}},
+          [=]()
+          {
+            std::shared_ptr<ChordSeq> chordSeq = createChordSeq(numNotes, shape, detune);
+            return [chordSeq](size_t numFrames)
+            {
+              float sum = 0.f;
+              for (size_t frame = 0; frame < numFrames; frame++)
+              {
+                chordSeq->doProcess(FRAME_INFO);
+                sum += chordSeq->audioOut1->getValue();
+              }
+              doNotOptimize(sum);
+            };
+          }};
+}
+
+void registerChordSeqBenchmarks(Registry &registry)
+{
+  for (size_t numNotes : {1, 2, 4, 8, 12, 16})
+  {
+    for (float shape : {0.f, 0.5f, 1.f})
+    {
+      for (float detune : {0.f, 1.f})
+      {
+        registry.push_back(processBenchmark(numNotes, shape, detune));
+      }
+    }
+  }
+}
@@ -0,0 +1,136 @@
+#include <daisysp.h>
+#include "../src/core2/engine/Engine.hpp"
+#include "../src/core2/engine/Oversampler.hpp"
+#include "../src/core/dsp/Trigger.hpp"
+#include "Bench.hpp"
+
+using namespace phnq::bench;
+
+static Benchmark pitchToFrequencyBenchmark()
+{
+  return {"pitchToFrequency", {}, []()
+          {
+            return [](size_t numFrames)
+            {
+              float sum = 0.f;
+              for (size_t i = 0; i < numFrames; i++)
+              {
+                sum += phnq::engine::pitchToFrequency((i & 1023) / 1024.f);
+              }
+              doNotOptimize(sum);
+            };
+          }};
+}
+
+static Benchmark variableShapeOscillatorBenchmark(float shape)
+{
+  return {"VariableShapeOscillator", {{"shape", shape}}, [shape]()
+          {
+            std::shared_ptr<daisysp::VariableShapeOscillator> osc(new daisysp::VariableShapeOscillator());
+            osc->Init(SAMPLE_RATE);
+            osc->SetWaveshape(shape);
+            return [osc](size_t numFrames)
+            {
+              float sum = 0.f;
+              for (size_t i = 0; i < numFrames; i++)
+              {
+                // Same per-sample call sequence PolyVox makes for each oscillator.
+                osc->SetSyncFreq(220.f + (i & 255));
+                osc->SetPW(0.5f);
+                sum += osc->Process();
+              }
+              doNotOptimize(sum);
+            };
+          }};
+}
+
+static Benchmark portBenchmark(float glide)
+{
+  return {"Port", {{"glide", glide}}, [glide]()
+          {
+            std::shared_ptr<daisysp::Port> port(new daisysp::Port());
+            port->Init(SAMPLE_RATE, glide);
+            return [port, glide](size_t numFrames)
+            {
+              float sum = 0.f;
+              for (size_t i = 0; i < numFrames; i++)
+              {
+                port->SetHtime(glide);
+                sum += port->Process(i & 4096 ? 0.3f : 0.6f);
+              }
+              doNotOptimize(sum);
+            };
+          }};
+}
+
+static Benchmark triggerBenchmark()
+{
+  return {"Trigger", {}, []()
+          {
+            std::shared_ptr<phnq::Trigger> trigger(new phnq::Trigger());
+            trigger->init(SAMPLE_RATE);
+            return [trigger](size_t numFrames)
+            {
+              size_t numActive = 0;
+              for (size_t i = 0; i < numFrames; i++)
+              {
+                if ((i & 1023) == 0)
+                {
+                  trigger->activate();
+                }
+                numActive += trigger->process();
+              }
+              doNotOptimize(numActive);
+            };
+          }};
+}
+
+const size_t OVERSAMPLER_BLOCK_SIZE = 64;
+
+static Benchmark oversamplerBenchmark(size_t factor)
+{
+  return {"Oversampler", {{"factor", (double)factor}}, [factor]()
+          {
+            std::shared_ptr<phnq::engine::Oversampler> upsampler(new phnq::engine::Oversampler());
+            std::shared_ptr<phnq::engine::Oversampler> downsampler(new phnq::engine::Oversampler());
+            upsampler->init(factor, OVERSAMPLER_BLOCK_SIZE, false);
+            downsampler->init(factor, OVERSAMPLER_BLOCK_SIZE, true);
+            std::shared_ptr<std::vector<float>> oversampled(new std::vector<float>(OVERSAMPLER_BLOCK_SIZE * factor));
+            return [upsampler, downsampler, oversampled](size_t numFrames)
+            {
+              // A round trip up and down, the filtering an oversampled engine adds.
+              float in[OVERSAMPLER_BLOCK_SIZE], out[OVERSAMPLER_BLOCK_SIZE];
+              float sum = 0.f;
+              for (size_t frame = 0; frame < numFrames; frame += OVERSAMPLER_BLOCK_SIZE)
+              {
+                size_t numBlockFrames = std::min(OVERSAMPLER_BLOCK_SIZE, numFrames - frame);
+                for (size_t i = 0; i < numBlockFrames; i++)
+                {
+                  in[i] = ((frame + i) & 255) / 256.f;
+                }
+                upsampler->upsample(in, numBlockFrames, oversampled->data());
+                downsampler->downsample(oversampled->data(), numBlockFrames, out);
+                sum += out[0];
+              }
+              doNotOptimize(sum);
+            };
+          }};
+}
+
+void registerDspBenchmarks(Registry &registry)
+{
+  registry.push_back(pitchToFrequencyBenchmark());
+  for (float shape : {0.f, 0.5f, 1.f})
+  {
+    registry.push_back(variableShapeOscillatorBenchmark(shape));
+  }
+  for (float glide : {0.f, 0.5f})
+  {
+    registry.push_back(portBenchmark(glide));
+  }
+  registry.push_back(triggerBenchmark());
+  for (size_t factor : {2, 4, 8})
+  {
+    registry.push_back(oversamplerBenchmark(factor));
+  }
+}
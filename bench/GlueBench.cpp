@@ -0,0 +1,142 @@
+#include "../src/core/Engine.hpp"
+#include "../src/core2/engine/Engine.hpp"
+#include "Bench.hpp"
+
+using namespace phnq::bench;
+
+/**
+ * Adapter Glue
+ * ============
+ * Measures only what an adapter spends per frame getting at an engine's ports:
+ * fetching each port list and visiting every port, with no DSP. The `copy`
+ * variants copy each list into a vector the way the getters used to, for
+ * comparison with the current non-copying getters.
+ */
+
+/**
+ * @brief A core2 engine with `numPorts` ports of every kind.
+ */
+struct GlueEngine : phnq::engine::Engine
+{
+  GlueEngine(size_t numPorts)
+  {
+    for (size_t i = 0; i < numPorts; i++)
+    {
+      createAudioIn("audioIn");
+      createAudioOut("audioOut");
+      createCVIn("cvIn");
+      createCVOut("cvOut");
+      createGateIn("gateIn");
+      createGateOut("gateOut");
+      createParam("param");
+      createLight("light");
+    }
+  }
+};
+
+/**
+ * @brief A legacy engine with `numPorts` ports of every kind, at most 2.
+ */
+struct GlueModule : phnq::Engine
+{
+  GlueModule(size_t numPorts)
+  {
+    for (size_t i = 0; i < numPorts; i++)
+    {
+      addIOPort(phnq::IOPortType::Audio, phnq::IOPortDirection::Input, "audioIn");
+      addIOPort(phnq::IOPortType::Audio, phnq::IOPortDirection::Output, "audioOut");
+      addIOPort(phnq::IOPortType::CV, phnq::IOPortDirection::Input, "cvIn");
+      addIOPort(phnq::IOPortType::CV, phnq::IOPortDirection::Output, "cvOut");
+      addIOPort(phnq::IOPortType::Gate, phnq::IOPortDirection::Input, "gateIn");
+      addIOPort(phnq::IOPortType::Gate, phnq::IOPortDirection::Output, "gateOut");
+      addIOPort(phnq::IOPortType::Param, phnq::IOPortDirection::Input, "param");
+      addIOPort(phnq::IOPortType::Led, phnq::IOPortDirection::Output, "led");
+    }
+  }
+
+  void process(phnq::FrameInfo frameInfo) override
+  {
+  }
+};
+
+template <class TPorts>
+static float visitPorts(const TPorts &ports)
+{
+  float sum = 0.f;
+  for (auto *port : ports)
+  {
+    sum += port->getValue();
+  }
+  return sum;
+}
+
+template <class T>
+static float visitPorts(phnq::engine::PortView<T> ports, bool copy)
+{
+  return copy ? visitPorts(std::vector<T *>(ports.begin(), ports.end())) : visitPorts(ports);
+}
+
+static Benchmark engineBenchmark(size_t numPorts, bool copy)
+{
+  return {"Glue/engine",
+          {{"ports", (double)numPorts}, {"copy", (double)copy}},
+          [=]()
+          {
+            std::shared_ptr<GlueEngine> engine(new GlueEngine(numPorts));
+            return [engine, copy](size_t numFrames)
+            {
+              float sum = 0.f;
+              for (size_t frame = 0; frame < numFrames; frame++)
+              {
+                sum += visitPorts(engine->getAudioIns(), copy);
+                sum += visitPorts(engine->getAudioOuts(), copy);
+                sum += visitPorts(engine->getCVIns(), copy);
+                sum += visitPorts(engine->getCVOuts(), copy);
+                sum += visitPorts(engine->getGateIns(), copy);
+                sum += visitPorts(engine->getGateOuts(), copy);
+                sum += visitPorts(engine->getParams(), copy);
+                sum += visitPorts(engine->getLights(), copy);
+              }
+              doNotOptimize(sum);
+            };
+          }};
+}
+
+static Benchmark legacyBenchmark(size_t numPorts, bool copy)
+{
+  return {"Glue/legacy",
+          {{"ports", (double)numPorts}, {"copy", (double)copy}},
+          [=]()
+          {
+            std::shared_ptr<GlueModule> module(new GlueModule(numPorts));
+            return [module, copy](size_t numFrames)
+            {
+              float sum = 0.f;
+              for (size_t frame = 0; frame < numFrames; frame++)
+              {
+                sum += copy ? visitPorts(std::vector<phnq::IOPort *>(module->getIOPorts())) : visitPorts(module->getIOPorts());
+              }
+              doNotOptimize(sum);
+            };
+          }};
+}
+
+void registerGlueBenchmarks(Registry &registry)
+{
+  for (size_t numPorts : {1, 4, 8})
+  {
+    for (bool copy : {true, false})
+    {
+      registry.push_back(engineBenchmark(numPorts, copy));
+    }
+  }
+
+  // The legacy engine allows at most 2 audio ins/outs and CV outs.
+  for (size_t numPorts : {1, 2})
+  {
+    for (bool copy : {true, false})
+    {
+      registry.push_back(legacyBenchmark(numPorts, copy));
+    }
+  }
+}
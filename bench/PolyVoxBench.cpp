@@ -0,0 +1,323 @@
+#include "../src/modules/PolyVox/PolyVox.cpp"
+#include "../src/core2/engine/EngineGraph.hpp"
+#include "../src/core2/engine/Oversampled.hpp"
+#include "../src/core2/host/WorkStealingScheduler.hpp"
+#include "Bench.hpp"
+
+using namespace phnq::bench;
+
+const FrameInfo FRAME_INFO = {SAMPLE_RATE, 1.f / SAMPLE_RATE};
+
+/**
+ * @brief Make `polyVox` play a single chord of `numNotes` notes, recorded through
+ * its ports the same way a user would.
+ */
+static void recordChord(PolyVox *polyVox, size_t numNotes, float shape, float detune, float glide)
+{
+  polyVox->doProcess(FRAME_INFO);
+
+  polyVox->addChordButton->setValue(1.f);
+  polyVox->addChordButton->setValue(0.f);
+  for (size_t i = 0; i < numNotes; i++)
+  {
+    // Stack major thirds upwards from C3.
+    polyVox->addNoteCVIn->setValue(0.2f + i * 4.f / 120.f);
+    polyVox->addNoteGateIn->setValue(true);
+    polyVox->addNoteGateIn->setValue(false);
+  }
+  polyVox->addChordButton->setValue(1.f);
+  polyVox->addChordButton->setValue(0.f);
+
+  polyVox->shapeKnob->setValue(shape);
+  polyVox->detuneKnob->setValue(detune);
+  polyVox->glideKnob->setValue(glide);
+}
+
+static std::shared_ptr<PolyVox> createPolyVox(size_t numNotes, float shape, float detune, float glide)
+{
+  std::shared_ptr<PolyVox> polyVox(new PolyVox());
+  recordChord(polyVox.get(), numNotes, shape, detune, glide);
+  return polyVox;
+}
+
+typedef PortSchema<2, 2, 0, 0, 0, 0, 0, 0, 0> GainPorts;
+
+/**
+ * @brief A stereo gain stage standing in for an effect after PolyVox.
+ */
+struct Gain : StaticEngine<GainPorts>
+{
+  AudioIn *audioInLeft = createAudioIn("audioInLeft");
+  AudioIn *audioInRight = createAudioIn("audioInRight");
+  AudioOut *audioOutLeft = createAudioOut("audioOutLeft");
+  AudioOut *audioOutRight = createAudioOut("audioOutRight");
+
+protected:
+  void process(FrameInfo frameInfo) override
+  {
+    audioOutLeft->setValue(audioInLeft->getValue() * 0.5f);
+    audioOutRight->setValue(audioInRight->getValue() * 0.5f);
+  }
+
+  void processBlock(FrameInfo frameInfo, size_t numFrames) override
+  {
+    for (size_t frame = 0; frame < numFrames; frame++)
+    {
+      audioOutLeft->getBlock()[frame] = audioInLeft->getBlock()[frame] * 0.5f;
+      audioOutRight->getBlock()[frame] = audioInRight->getBlock()[frame] * 0.5f;
+    }
+  }
+};
+
+typedef PortSchema<0, 2, 0, 0, 0, 0, 0, 0, 0> VoxChainPorts;
+
+/**
+ * @brief PolyVox alone or feeding `numGains` gain stages, in an EngineGraph.
+ */
+struct VoxChain : EngineGraph<VoxChainPorts>
+{
+  AudioOut *audioOutLeft = createAudioOut("audioOutLeft");
+  AudioOut *audioOutRight = createAudioOut("audioOutRight");
+  PolyVox *polyVox = addNode(new PolyVox());
+
+  VoxChain(size_t numGains)
+  {
+    AudioOut *left = polyVox->audioOutLeft;
+    AudioOut *right = polyVox->audioOutRight;
+    for (size_t i = 0; i < numGains; i++)
+    {
+      Gain *gain = addNode(new Gain());
+      connect(left, gain->audioInLeft);
+      connect(right, gain->audioInRight);
+      left = gain->audioOutLeft;
+      right = gain->audioOutRight;
+    }
+    connect(left, audioOutLeft);
+    connect(right, audioOutRight);
+  }
+};
+
+static Benchmark processBlockBenchmark(size_t numNotes, float shape, float detune, float glide)
+{
+  return {"PolyVox/processBlock",
+          {{"notes", (double)numNotes}, {"shape", shape}, {"detune", detune}, {"glide", glide}},
+          [=]()
+          {
+            std::shared_ptr<PolyVox> polyVox = createPolyVox(numNotes, shape, detune, glide);
+            return [polyVox](size_t numFrames)
+            {
+              runBlocks(polyVox.get(), numFrames);
+            };
+          }};
+}
+
+static Benchmark wavetableBenchmark(size_t numNotes, float shape, bool wavetable)
+{
+  return {"PolyVox/wavetable",
+          {{"notes", (double)numNotes}, {"shape", shape}, {"wavetable", wavetable ? 1.0 : 0.0}},
+          [=]()
+          {
+            std::shared_ptr<PolyVox> polyVox = createPolyVox(numNotes, shape, 1.f, 0.f);
+            polyVox->setWavetable(wavetable);
+            return [polyVox](size_t numFrames)
+            {
+              runBlocks(polyVox.get(), numFrames);
+            };
+          }};
+}
+
+static Benchmark processBenchmark(size_t numNotes)
+{
+  return {"PolyVox/process",
+          {{"notes", (double)numNotes}},
+          [=]()
+          {
+            std::shared_ptr<PolyVox> polyVox = createPolyVox(numNotes, 0.5f, 0.5f, 0.f);
+            return [polyVox](size_t numFrames)
+            {
+              float sum = 0.f;
+              for (size_t frame = 0; frame < numFrames; frame++)
+              {
+                polyVox->doProcess(FRAME_INFO);
+                sum += polyVox->audioOutLeft->getValue();
+              }
+              doNotOptimize(sum);
+            };
+          }};
+}
+
+const size_t NUM_BANK_VOICES = 8;
+
+typedef PortSchema<2 * NUM_BANK_VOICES, 2, 0, 0, 0, 0, 0, 0, 0> MixerPorts;
+
+/**
+ * @brief Sums `NUM_BANK_VOICES` stereo inputs.
+ */
+struct Mixer : StaticEngine<MixerPorts>
+{
+  Mixer()
+  {
+    for (size_t i = 0; i < 2 * NUM_BANK_VOICES; i++)
+    {
+      createAudioIn("audioIn");
+    }
+    createAudioOut("audioOutLeft");
+    createAudioOut("audioOutRight");
+  }
+
+protected:
+  void processBlock(FrameInfo frameInfo, size_t numFrames) override
+  {
+    for (size_t side = 0; side < 2; side++)
+    {
+      float *out = getAudioOuts()[side]->getBlock();
+      std::fill(out, out + numFrames, 0.f);
+      for (size_t i = side; i < 2 * NUM_BANK_VOICES; i += 2)
+      {
+        const float *in = getAudioIns()[i]->getBlock();
+        for (size_t frame = 0; frame < numFrames; frame++)
+        {
+          out[frame] += in[frame];
+        }
+      }
+    }
+  }
+};
+
+/**
+ * @brief `NUM_BANK_VOICES` independent PolyVox branches, each through a gain
+ * stage, into a mixer: the shape a WorkStealingScheduler can run in parallel.
+ */
+struct VoxBank : EngineGraph<VoxChainPorts>
+{
+  AudioOut *audioOutLeft = createAudioOut("audioOutLeft");
+  AudioOut *audioOutRight = createAudioOut("audioOutRight");
+  std::vector<PolyVox *> polyVoxes;
+
+  VoxBank()
+  {
+    Mixer *mixer = addNode(new Mixer());
+    for (size_t i = 0; i < NUM_BANK_VOICES; i++)
+    {
+      PolyVox *polyVox = addNode(new PolyVox());
+      Gain *gain = addNode(new Gain());
+      connect(polyVox->audioOutLeft, gain->audioInLeft);
+      connect(polyVox->audioOutRight, gain->audioInRight);
+      connect(gain->audioOutLeft, mixer->getAudioIns()[2 * i]);
+      connect(gain->audioOutRight, mixer->getAudioIns()[2 * i + 1]);
+      polyVoxes.push_back(polyVox);
+    }
+    connect(mixer->getAudioOuts()[0], audioOutLeft);
+    connect(mixer->getAudioOuts()[1], audioOutRight);
+  }
+};
+
+static Benchmark graphBenchmark(size_t numNotes, size_t numGains)
+{
+  return {"PolyVox/graph",
+          {{"notes", (double)numNotes}, {"gains", (double)numGains}},
+          [=]()
+          {
+            std::shared_ptr<VoxChain> chain(new VoxChain(numGains));
+            recordChord(chain->polyVox, numNotes, 0.5f, 1.f, 0.f);
+            return [chain](size_t numFrames)
+            {
+              runBlocks(chain.get(), numFrames);
+            };
+          }};
+}
+
+static Benchmark bankBenchmark(size_t numNotes, size_t numThreads)
+{
+  return {"PolyVox/bank",
+          {{"notes", (double)numNotes}, {"threads", (double)numThreads}},
+          [=]()
+          {
+            std::shared_ptr<phnq::host::WorkStealingScheduler> scheduler(new phnq::host::WorkStealingScheduler(numThreads));
+            std::shared_ptr<VoxBank> bank(new VoxBank());
+            for (PolyVox *polyVox : bank->polyVoxes)
+            {
+              recordChord(polyVox, numNotes, 0.5f, 1.f, 0.f);
+            }
+            if (numThreads > 1)
+            {
+              bank->setScheduler(scheduler.get());
+            }
+            return [scheduler, bank](size_t numFrames)
+            {
+              runBlocks(bank.get(), numFrames);
+            };
+          }};
+}
+
+template <size_t Factor>
+static Benchmark oversampledBenchmark(size_t numNotes)
+{
+  return {"PolyVox/oversampled",
+          {{"notes", (double)numNotes}, {"factor", (double)Factor}},
+          [=]()
+          {
+            std::shared_ptr<Oversampled<PolyVox, Factor>> oversampled(new Oversampled<PolyVox, Factor>());
+            recordChord(oversampled->engine, numNotes, 0.5f, 1.f, 0.f);
+            return [oversampled](size_t numFrames)
+            {
+              runBlocks(oversampled.get(), numFrames);
+            };
+          }};
+}
+
+void registerPolyVoxBenchmarks(Registry &registry)
+{
+  for (size_t numNotes = 1; numNotes <= 16; numNotes++)
+  {
+    registry.push_back(processBenchmark(numNotes));
+  }
+
+  for (size_t numNotes : {1, 2, 4, 8, 12, 16})
+  {
+    for (float shape : {0.f, 0.5f, 1.f})
+    {
+      for (float detune : {0.f, 1.f})
+      {
+        for (float glide : {0.f, 0.5f})
+        {
+          registry.push_back(processBlockBenchmark(numNotes, shape, detune, glide));
+        }
+      }
+    }
+  }
+
+  // polyBLEP (wavetable 0) against wavetable oscillators, detuned, no glide.
+  for (size_t numNotes : {1, 8, 16})
+  {
+    for (float shape : {0.f, 0.5f, 1.f})
+    {
+      registry.push_back(wavetableBenchmark(numNotes, shape, false));
+      registry.push_back(wavetableBenchmark(numNotes, shape, true));
+    }
+  }
+
+  // Compare with PolyVox/processBlock at shape 0.5, detune 1, glide 0.
+  for (size_t numNotes : {1, 8})
+  {
+    for (size_t numGains : {0, 1, 4})
+    {
+      registry.push_back(graphBenchmark(numNotes, numGains));
+    }
+  }
+
+  // Eight voices on 1 (in order), 2 and 4 threads.
+  for (size_t numThreads : {1, 2, 4})
+  {
+    registry.push_back(bankBenchmark(8, numThreads));
+  }
+
+  // CPU cost per oversampling factor; factor 1 is the plain graph overhead.
+  for (size_t numNotes : {1, 8})
+  {
+    registry.push_back(oversampledBenchmark<1>(numNotes));
+    registry.push_back(oversampledBenchmark<2>(numNotes));
+    registry.push_back(oversampledBenchmark<4>(numNotes));
+    registry.push_back(oversampledBenchmark<8>(numNotes));
+  }
+}
@@ -0,0 +1,88 @@
+#include "../src/core/simd/Simd.hpp"
+#include "Bench.hpp"
+
+using namespace phnq::bench;
+
+/**
+ * phnq::simd
+ * ==========
+ * The vector layer against the scalar code it replaces, on one 48-frame block
+ * per run step. Build with -DPHNQ_SIMD_SCALAR to measure the scalar backend.
+ */
+
+static Benchmark mulAddBenchmark(bool vector)
+{
+  return {"Simd/mulAdd", {{"vector", (double)vector}}, [vector]()
+          {
+            std::shared_ptr<std::vector<float>> in(new std::vector<float>(BLOCK_SIZE, 0.25f));
+            std::shared_ptr<std::vector<float>> out(new std::vector<float>(BLOCK_SIZE, 0.f));
+            return [in, out, vector](size_t numFrames)
+            {
+              for (size_t frame = 0; frame < numFrames; frame += BLOCK_SIZE)
+              {
+                size_t numBlockFrames = std::min(BLOCK_SIZE, numFrames - frame);
+                if (vector)
+                {
+                  phnq::simd::mulAdd(in->data(), 0.5f, out->data(), numBlockFrames);
+                }
+                else
+                {
+                  for (size_t i = 0; i < numBlockFrames; i++)
+                  {
+                    (*out)[i] += (*in)[i] * 0.5f;
+                  }
+                }
+              }
+              doNotOptimize((*out)[0]);
+            };
+          }};
+}
+
+static Benchmark fastExp2Benchmark(size_t numLanes)
+{
+  return {"Simd/fastExp2", {{"lanes", (double)numLanes}}, [numLanes]()
+          {
+            return [numLanes](size_t numFrames)
+            {
+              float sum = 0.f;
+              if (numLanes == 8)
+              {
+                phnq::simd::Float8 acc(0.f);
+                for (size_t i = 0; i + 8 <= numFrames; i += 8)
+                {
+                  acc += phnq::simd::fastExp2(phnq::simd::Float8((i & 1023) / 1024.f));
+                }
+                sum = phnq::simd::sum(acc);
+              }
+              else if (numLanes == 4)
+              {
+                phnq::simd::Float4 acc(0.f);
+                for (size_t i = 0; i + 4 <= numFrames; i += 4)
+                {
+                  acc += phnq::simd::fastExp2(phnq::simd::Float4((i & 1023) / 1024.f));
+                }
+                sum = phnq::simd::sum(acc);
+              }
+              else
+              {
+                for (size_t i = 0; i < numFrames; i++)
+                {
+                  sum += phnq::fastExp2((i & 1023) / 1024.f);
+                }
+              }
+              doNotOptimize(sum);
+            };
+          }};
+}
+
+void registerSimdBenchmarks(Registry &registry)
+{
+  for (bool vector : {false, true})
+  {
+    registry.push_back(mulAddBenchmark(vector));
+  }
+  for (size_t numLanes : {1, 4, 8})
+  {
+    registry.push_back(fastExp2Benchmark(numLanes));
+  }
+}
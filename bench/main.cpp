@@ -0,0 +1,188 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include "Bench.hpp"
+
+using namespace phnq::bench;
+
+volatile float phnq::bench::sink = 0.f;
+
+void registerDspBenchmarks(Registry &registry);
+void registerPolyVoxBenchmarks(Registry &registry);
+void registerChordSeqBenchmarks(Registry &registry);
+void registerGlueBenchmarks(Registry &registry);
+void registerSimdBenchmarks(Registry &registry);
+
+struct Stats
+{
+  double mean;
+  double median;
+  double stddev;
+  double min;
+  double max;
+  double p95;
+};
+
+struct Result
+{
+  const Benchmark *benchmark;
+  Stats nsPerSample;
+};
+
+static Stats computeStats(std::vector<double> samples)
+{
+  Stats stats = {0, 0, 0, 0, 0, 0};
+  if (samples.empty())
+  {
+    return stats;
+  }
+
+  std::sort(samples.begin(), samples.end());
+  size_t n = samples.size();
+
+  double sum = 0;
+  for (double sample : samples)
+  {
+    sum += sample;
+  }
+  stats.mean = sum / n;
+
+  double sumSquares = 0;
+  for (double sample : samples)
+  {
+    sumSquares += (sample - stats.mean) * (sample - stats.mean);
+  }
+  stats.stddev = n > 1 ? std::sqrt(sumSquares / (n - 1)) : 0;
+
+  stats.median = n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+  stats.min = samples.front();
+  stats.max = samples.back();
+  stats.p95 = samples[std::min(n - 1, (size_t)std::ceil(0.95 * n) - 1)];
+  return stats;
+}
+
+static void printUsage(const char *name)
+{
+  fprintf(stderr, "Usage: %s [-o results.json] [-f filter] [-n frames] [-r repetitions]\n", name);
+  fprintf(stderr, "  -o  JSON results file, default bench.json\n");
+  fprintf(stderr, "  -f  only run benchmarks whose name contains this string\n");
+  fprintf(stderr, "  -n  frames per repetition, default 4800\n");
+  fprintf(stderr, "  -r  timed repetitions per benchmark, default 25\n");
+}
+
+static void writeJSON(FILE *file, const std::vector<Result> &results, size_t numFrames, size_t numRepetitions)
+{
+  fprintf(file, "{\n");
+  fprintf(file, "  \"context\": {\"sampleRate\": %.0f, \"framesPerRepetition\": %lu, \"repetitions\": %lu, \"compiler\": \"%s\"},\n",
+          SAMPLE_RATE, (unsigned long)numFrames, (unsigned long)numRepetitions, __VERSION__);
+  fprintf(file, "  \"benchmarks\": [");
+  for (size_t i = 0; i < results.size(); i++)
+  {
+    const Result &result = results[i];
+    const Stats &stats = result.nsPerSample;
+
+    fprintf(file, "%s\n    {\"name\": \"%s\", \"params\": {", i ? "," : "", result.benchmark->name.c_str());
+    for (size_t p = 0; p < result.benchmark->params.size(); p++)
+    {
+      const Param &param = result.benchmark->params[p];
+      fprintf(file, "%s\"%s\": %g", p ? ", " : "", param.name.c_str(), param.value);
+    }
+    fprintf(file, "}, \"nsPerSample\": {\"mean\": %.3f, \"median\": %.3f, \"stddev\": %.3f, \"min\": %.3f, \"max\": %.3f, \"p95\": %.3f}",
+            stats.mean, stats.median, stats.stddev, stats.min, stats.max, stats.p95);
+
+    // Fraction of one core needed to run this in real time at SAMPLE_RATE.
+    fprintf(file, ", \"realtimeLoad\": %.6f}", stats.median * SAMPLE_RATE / 1e9);
+  }
+  fprintf(file, "\n  ]\n}\n");
+}
+
+int main(int argc, char **argv)
+{
+  const char *outPath = "bench.json";
+  const char *filter = "";
+  size_t numFrames = 4800;
+  size_t numRepetitions = 25;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "o:f:n:r:h")) != -1)
+  {
+    switch (opt)
+    {
+    case 'o':
+      outPath = optarg;
+      break;
+    case 'f':
+      filter = optarg;
+      break;
+    case 'n':
+      numFrames = strtoul(optarg, NULL, 10);
+      break;
+    case 'r':
+      numRepetitions = strtoul(optarg, NULL, 10);
+      break;
+    default:
+      printUsage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (numFrames == 0 || numRepetitions == 0)
+  {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  Registry registry;
+  registerDspBenchmarks(registry);
+  registerPolyVoxBenchmarks(registry);
+  registerChordSeqBenchmarks(registry);
+  registerGlueBenchmarks(registry);
+  registerSimdBenchmarks(registry);
+
+  std::vector<Result> results;
+  for (const Benchmark &benchmark : registry)
+  {
+    if (benchmark.name.find(filter) == std::string::npos)
+    {
+      continue;
+    }
+
+    Runner run = benchmark.setup();
+
+    // Warm up caches, branch predictors and any lazily initialized state.
+    run(numFrames);
+
+    std::vector<double> nsPerSample;
+    for (size_t rep = 0; rep < numRepetitions; rep++)
+    {
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      run(numFrames);
+      double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+      nsPerSample.push_back(elapsed / numFrames);
+    }
+
+    Result result = {&benchmark, computeStats(nsPerSample)};
+    results.push_back(result);
+
+    fprintf(stderr, "%-28s", benchmark.name.c_str());
+    for (const Param &param : benchmark.params)
+    {
+      fprintf(stderr, " %s=%-5g", param.name.c_str(), param.value);
+    }
+    fprintf(stderr, " %9.1f ns/sample (+/- %.1f)\n", result.nsPerSample.median, result.nsPerSample.stddev);
+  }
+
+  FILE *file = fopen(outPath, "w");
+  if (!file)
+  {
+    fprintf(stderr, "Could not open output file: %s\n", outPath);
+    return 1;
+  }
+  writeJSON(file, results, numFrames, numRepetitions);
+  fclose(file);
+  return 0;
+}
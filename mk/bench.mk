@@ -0,0 +1,33 @@
+PHNQ_DIR ?= .
+BUILD := build/bench
+
+SOURCES := $(shell find $(PHNQ_DIR)/bench -type f -name '*.cpp') $(shell find $(PHNQ_DIR)/vendor/DaisySP/Source -type f -name '*.cpp')
+OBJECTS := $(patsubst $(PHNQ_DIR)/%.cpp, $(BUILD)/obj/%.o, $(SOURCES))
+
+CXXFLAGS += -std=c++11 -O2 -MD
+CXXFLAGS += -ffp-contract=off # Keep SIMD and scalar results bit-identical (see src/core/simd/Simd.hpp).
+CXXFLAGS += -pthread
+LDFLAGS += -pthread
+CXXFLAGS += -I$(PHNQ_DIR)/vendor/DaisySP/Source -I$(PHNQ_DIR)/vendor/DaisySP/Source/Utility
+
+all: $(BUILD)/bench
+
+# e.g. make bench run BENCH_ARGS="-f PolyVox -r 50"
+run: $(BUILD)/bench
+	$(BUILD)/bench -o $(BUILD)/results.json $(BENCH_ARGS)
+
+clean:
+	rm -rf $(BUILD)
+
+print:
+	@echo $(SOURCES)
+
+$(BUILD)/bench: $(OBJECTS)
+	@mkdir -p $(@D)
+	$(CXX) -o $@ $^ $(LDFLAGS)
+
+$(BUILD)/obj/%.o: %.cpp
+	@mkdir -p $(@D)
+	$(CXX) $(CXXFLAGS) -c -o $@ $<
+
+-include $(OBJECTS:.o=.d)
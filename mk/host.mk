@@ -0,0 +1,40 @@
+PHNQ_DIR ?= .
+
+ifeq ($(TARGET),)
+$(error No TARGET specified -- i.e. TARGET=PolyVox make host)
+endif
+
+MODULE_DIR := $(PHNQ_DIR)/src/modules/$(TARGET)
+
+ifeq ($(wildcard $(PHNQ_DIR)/src/modules/$(TARGET)),)
+$(error No such module directory: $(MODULE_DIR))	
+endif
+
+BUILD := build/host
+
+SOURCES := $(shell find $(MODULE_DIR) -type f -name '*.cpp') $(shell find $(PHNQ_DIR)/vendor/DaisySP/Source -type f -name '*.cpp')
+OBJECTS := $(patsubst $(PHNQ_DIR)/%.cpp, $(BUILD)/%.o, $(SOURCES))
+
+CXXFLAGS += -std=c++11 -O2 -DPHNQ_HOST -MD
+CXXFLAGS += -ffp-contract=off # Keep SIMD and scalar results bit-identical (see src/core/simd/Simd.hpp).
+CXXFLAGS += -pthread
+LDFLAGS += -pthread
+CXXFLAGS += -I$(PHNQ_DIR)/vendor/DaisySP/Source -I$(PHNQ_DIR)/vendor/DaisySP/Source/Utility
+
+all: $(BUILD)/$(TARGET)
+
+clean:
+	rm -rf $(BUILD)
+
+print:
+	@echo $(SOURCES)
+
+$(BUILD)/$(TARGET): $(OBJECTS)
+	@mkdir -p $(@D)
+	$(CXX) -o $@ $^ $(LDFLAGS)
+
+$(BUILD)/%.o: %.cpp
+	@mkdir -p $(@D)
+	$(CXX) $(CXXFLAGS) -c -o $@ $<
+
+-include $(OBJECTS:.o=.d)
@@ -28,6 +28,7 @@ ifneq ($(ARCH),i386)
 $(error VCV Rack requires i386-based artifacts. Use arch -x86_64 make.)	
 endif
 CXXFLAGS += -std=c++11 -stdlib=libc++
+CXXFLAGS += -ffp-contract=off # Keep SIMD and scalar results bit-identical (see src/core/simd/Simd.hpp).
 CXXFLAGS += -DPHNQ_RACK
 CXXFLAGS += -I$(PHNQ_DIR)/vendor/Rack-SDK/include -I$(PHNQ_DIR)/vendor/Rack-SDK/dep/include -I$(PHNQ_DIR)/vendor/pugixml/src -I$(PHNQ_DIR)/vendor/fmt/include
 LDFLAGS += -stdlib=libc++ -L $(PHNQ_DIR)/vendor/Rack-SDK -lRack -undefined dynamic_lookup -fPIC -shared
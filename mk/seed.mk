@@ -14,6 +14,14 @@ endif
 CPP_SOURCES := $(shell find $(PHNQ_DIR)/src/core -type f -name '*.cpp') $(shell find $(MODULE_DIR) -type f -name '*.cpp')
 
 C_DEFS := -DPHNQ_SEED
+# CMSIS-DSP comes with libDaisy, and phnq::simd block kernels can use it with
+# -DPHNQ_SIMD_CMSIS, but that path hasn't been built with arm-none-eabi yet.
+# C_DEFS += -DPHNQ_SIMD_CMSIS
+
+# libDaisy builds in GNU mode, where GCC fuses multiply-adds onto the M7's
+# VFMA; keep SIMD and scalar results bit-identical (see src/core/simd/Simd.hpp).
+# libDaisy's core Makefile appends its own flags to these.
+CFLAGS += -ffp-contract=off
 
 # Library Locations
 LIBDAISY_DIR = $(PHNQ_DIR)/vendor/libDaisy
@@ -0,0 +1,33 @@
+PHNQ_DIR ?= .
+BUILD := build/test
+
+SOURCES := $(shell find $(PHNQ_DIR)/test -type f -name '*.cpp')
+TESTS := $(patsubst $(PHNQ_DIR)/test/%.cpp, $(BUILD)/%, $(SOURCES))
+
+# Each test again on the scalar SIMD backend, which the vector backends must
+# match bit for bit. Add -mavx2 to CXXFLAGS to check AVX2 too.
+SCALAR_TESTS := $(patsubst $(PHNQ_DIR)/test/%.cpp, $(BUILD)/scalar/%, $(SOURCES))
+
+CXXFLAGS += -std=c++11 -O2 -MD
+CXXFLAGS += -pthread
+CXXFLAGS += -ffp-contract=off
+CXXFLAGS += -I$(PHNQ_DIR)/vendor/DaisySP/Source -I$(PHNQ_DIR)/vendor/DaisySP/Source/Utility
+
+# e.g. make test run
+run: $(TESTS) $(SCALAR_TESTS)
+	@for test in $(TESTS) $(SCALAR_TESTS); do echo $$test; $$test || exit 1; done
+
+all: $(TESTS) $(SCALAR_TESTS)
+
+clean:
+	rm -rf $(BUILD)
+
+$(BUILD)/scalar/%: $(PHNQ_DIR)/test/%.cpp
+	@mkdir -p $(@D)
+	$(CXX) $(CXXFLAGS) -DPHNQ_SIMD_SCALAR -o $@ $<
+
+$(BUILD)/%: $(PHNQ_DIR)/test/%.cpp
+	@mkdir -p $(@D)
+	$(CXX) $(CXXFLAGS) -o $@ $<
+
+-include $(TESTS:=.d) $(SCALAR_TESTS:=.d)
@@ -2,10 +2,11 @@
 
 #include <string>
 #include <vector>
-#include <queue>
 #include <math.h>
 #include <assert.h>
 #include <daisysp.h>
+#include "dsp/RingBuffer.hpp"
+#include "dsp/Exp2.hpp"
 
 #ifdef PHNQ_RACK
 #include <rack.hpp>
@@ -49,7 +50,7 @@ namespace phnq
 
   static float pitchToFrequency(float pitch)
   {
-    return FREQ_C1 * std::pow(2.f, pitch * 10.f);
+    return FREQ_C1 * fastExp2(pitch * 10.f);
   }
 
   static void assertCondition(std::string text, bool condition)
@@ -118,7 +119,7 @@ namespace phnq
     float value;
     std::string panelId;
     uint16_t delay;
-    queue<float> delayBuffer;
+    RingBuffer<float> delayBuffer;
 
   public:
     IOPort(PortListener *portListener, IOPortType type, IOPortDirection dir, std::string panelId)
@@ -179,8 +180,7 @@ namespace phnq
         {
           return;
         }
-        value = delayBuffer.front();
-        delayBuffer.pop();
+        delayBuffer.pop(value);
       }
 
       switch (type)
@@ -232,6 +232,7 @@ namespace phnq
     IOPort *setDelay(uint16_t delay)
     {
       this->delay = delay;
+      this->delayBuffer.init(delay);
       return this;
     }
 
@@ -386,10 +387,13 @@ namespace phnq
       return ioConfig;
     }
 
-    vector<IOPort *> getIOPorts()
+    /**
+     * @brief All ports, in the order they were added. The list is owned by the engine
+     * and not copied.
+     */
+    const vector<IOPort *> &getIOPorts()
     {
-      vector<IOPort *> ioPortsCopy = ioPorts;
-      return ioPortsCopy;
+      return ioPorts;
     }
 
     void doProcess(FrameInfo frameInfo)
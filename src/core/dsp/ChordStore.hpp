@@ -0,0 +1,288 @@
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+namespace phnq
+{
+  /**
+   * @brief A pitch CV (1/10 per octave) in 16-bit fixed point: 1/32768 per step,
+   * covering -1 (-10 octaves) to just under 1. Steps are 0.37 cents.
+   */
+  typedef int16_t PitchCode;
+
+  const float PITCH_CODE_SCALE = 32768.f;
+
+  /**
+   * @brief The nearest `PitchCode` to `pitch`, clamped to the code range.
+   */
+  inline PitchCode encodePitch(float pitch)
+  {
+    float code = roundf(pitch * PITCH_CODE_SCALE);
+    return (PitchCode)(code < -32768.f ? -32768.f : code > 32767.f ? 32767.f : code);
+  }
+
+  inline float decodePitch(PitchCode code)
+  {
+    return code * (1.f / PITCH_CODE_SCALE);
+  }
+
+  /**
+   * @brief A chord sequence laid out flat: every chord's notes in one array of
+   * `PitchCode`s, in sequence order, with chord `i` at `notes[offsets[i]]` to
+   * `notes[offsets[i + 1]]`. A step costs 2 bytes plus 2 per note, so thousands
+   * of steps fit in a few tens of KB, and any note decodes in O(1).
+   */
+  template <size_t MaxChords, size_t MaxNotes>
+  struct Chords
+  {
+    static_assert(MaxChords < 65536 && MaxNotes < 65536, "Chords indexes chords and notes with 16 bits");
+
+    uint16_t numChords = 0;
+    uint16_t largestChordSize = 0; // Kept up to date by ChordStore's edits.
+    uint32_t version = 0;          // Bumped by every edit.
+    uint16_t offsets[MaxChords + 1] = {};
+    PitchCode notes[MaxNotes] = {};
+
+    size_t size() const
+    {
+      return numChords;
+    }
+
+    bool empty() const
+    {
+      return numChords == 0;
+    }
+
+    size_t numNotes() const
+    {
+      return offsets[numChords];
+    }
+
+    size_t chordSize(size_t chord) const
+    {
+      return offsets[chord + 1] - offsets[chord];
+    }
+
+    /**
+     * @brief Note `note` of chord `chord`, decoded.
+     */
+    float note(size_t chord, size_t note) const
+    {
+      return decodePitch(notes[offsets[chord] + note]);
+    }
+
+    size_t maxChordSize() const
+    {
+      return largestChordSize;
+    }
+  };
+
+  /**
+   * @brief Fixed-capacity chord sequence edited by one thread and played by
+   * another (which may be the same one), without locks or allocation.
+   *
+   * Edits are made on a back buffer, then published with one atomic exchange,
+   * so the player only ever sees whole edits. `read()` picks up the latest
+   * published sequence and the player keeps that view until it next calls
+   * `read()`. A third buffer sits between the two, so the editor never writes
+   * to a buffer the player may still be reading (triple buffering).
+   *
+   * Edit methods are for the editing thread only; each one publishes itself.
+   * They return false, changing nothing, when the sequence is full. Publishing
+   * brings the editor's next buffer up to date by copying only what the edits
+   * it missed changed (usually the tail from the edited chord on), so editing
+   * is cheap enough for the audio thread.
+   */
+  template <size_t MaxChords, size_t MaxNotes>
+  struct ChordStore
+  {
+    typedef phnq::Chords<MaxChords, MaxNotes> Chords;
+
+  private:
+    static const size_t INDEX_MASK = 3;
+    static const size_t FRESH = 4; // Set on the middle buffer when it was published since the last `read()`.
+
+    /**
+     * @brief What an edit may have changed: offsets from `firstOffset` to the
+     * chord count, and notes from `firstNote` up to `endNote` (or the note count).
+     */
+    struct EditRange
+    {
+      size_t firstOffset;
+      size_t firstNote;
+      size_t endNote;
+    };
+
+    // Ranges of the most recent edits, by version. A buffer further behind than
+    // this is copied whole.
+    static const size_t EDIT_LOG_SIZE = 4;
+
+    Chords buffers[3];
+    size_t back = 0;  // Editor's buffer.
+    size_t front = 1; // Player's buffer.
+    std::atomic<size_t> middle;
+    EditRange editLog[EDIT_LOG_SIZE];
+
+    void publish(EditRange range)
+    {
+      buffers[back].version++;
+      const Chords &published = buffers[back];
+      editLog[published.version % EDIT_LOG_SIZE] = range;
+      back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+
+      // The editor carries on from what it just published. Only the editor
+      // writes buffers, so reading the published one here is safe. Whatever the
+      // edits since this buffer's version didn't touch is already the same.
+      Chords &edits = buffers[back];
+      uint32_t numMissed = published.version - edits.version;
+      EditRange missed = {0, 0, SIZE_MAX};
+      if (numMissed <= EDIT_LOG_SIZE)
+      {
+        missed = {SIZE_MAX, SIZE_MAX, 0};
+        for (uint32_t version = edits.version + 1; version != published.version + 1; version++)
+        {
+          const EditRange &edit = editLog[version % EDIT_LOG_SIZE];
+          missed.firstOffset = edit.firstOffset < missed.firstOffset ? edit.firstOffset : missed.firstOffset;
+          missed.firstNote = edit.firstNote < missed.firstNote ? edit.firstNote : missed.firstNote;
+          missed.endNote = edit.endNote > missed.endNote ? edit.endNote : missed.endNote;
+        }
+      }
+
+      edits.numChords = published.numChords;
+      edits.largestChordSize = published.largestChordSize;
+      edits.version = published.version;
+      if (missed.firstOffset <= published.numChords)
+      {
+        memcpy(&edits.offsets[missed.firstOffset], &published.offsets[missed.firstOffset], (published.numChords + 1 - missed.firstOffset) * sizeof(edits.offsets[0]));
+      }
+      size_t endNote = missed.endNote < published.numNotes() ? missed.endNote : published.numNotes();
+      if (missed.firstNote < endNote)
+      {
+        memcpy(&edits.notes[missed.firstNote], &published.notes[missed.firstNote], (endNote - missed.firstNote) * sizeof(edits.notes[0]));
+      }
+    }
+
+  public:
+    ChordStore() : middle(2)
+    {
+    }
+
+    /**
+     * @brief Player side: the latest published sequence.
+     */
+    const Chords &read()
+    {
+      if (middle.load(std::memory_order_relaxed) & FRESH)
+      {
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+      }
+      return buffers[front];
+    }
+
+    /**
+     * @brief Editor side: the sequence with every edit so far applied.
+     */
+    const Chords &edited()
+    {
+      return buffers[back];
+    }
+
+    void clear()
+    {
+      buffers[back].numChords = 0;
+      buffers[back].largestChordSize = 0;
+      publish({SIZE_MAX, SIZE_MAX, 0});
+    }
+
+    /**
+     * @brief Insert an empty chord before chord `index` (or at the end, if `index`
+     * is the size).
+     */
+    bool insertChord(size_t index)
+    {
+      Chords &edits = buffers[back];
+      if (edits.numChords == MaxChords || index > edits.numChords)
+      {
+        return false;
+      }
+      memmove(&edits.offsets[index + 1], &edits.offsets[index], (edits.numChords + 1 - index) * sizeof(edits.offsets[0]));
+      edits.numChords++;
+      publish({index, SIZE_MAX, 0});
+      return true;
+    }
+
+    bool removeChord(size_t index)
+    {
+      Chords &edits = buffers[back];
+      if (index >= edits.numChords)
+      {
+        return false;
+      }
+      size_t start = edits.offsets[index];
+      size_t count = edits.chordSize(index);
+      memmove(&edits.notes[start], &edits.notes[start + count], (edits.numNotes() - start - count) * sizeof(edits.notes[0]));
+      for (size_t chord = index + 1; chord <= edits.numChords; chord++)
+      {
+        edits.offsets[chord - 1] = edits.offsets[chord] - count;
+      }
+      edits.numChords--;
+
+      // Only losing a largest chord can shrink the largest size.
+      if (count == edits.largestChordSize)
+      {
+        edits.largestChordSize = 0;
+        for (size_t chord = 0; chord < edits.numChords; chord++)
+        {
+          edits.largestChordSize = edits.chordSize(chord) > edits.largestChordSize ? edits.chordSize(chord) : edits.largestChordSize;
+        }
+      }
+      publish({index, start, SIZE_MAX});
+      return true;
+    }
+
+    /**
+     * @brief Append a note to chord `index`, rounded to the nearest `PitchCode`.
+     */
+    bool addNote(size_t index, float note)
+    {
+      Chords &edits = buffers[back];
+      if (index >= edits.numChords || edits.numNotes() == MaxNotes)
+      {
+        return false;
+      }
+      size_t end = edits.offsets[index + 1];
+      memmove(&edits.notes[end + 1], &edits.notes[end], (edits.numNotes() - end) * sizeof(edits.notes[0]));
+      edits.notes[end] = encodePitch(note);
+      for (size_t chord = index + 1; chord <= edits.numChords; chord++)
+      {
+        edits.offsets[chord]++;
+      }
+      if (edits.chordSize(index) > edits.largestChordSize)
+      {
+        edits.largestChordSize = edits.chordSize(index);
+      }
+      publish({index + 1, end, SIZE_MAX});
+      return true;
+    }
+
+    /**
+     * @brief Replace note `noteIndex` of chord `index`.
+     */
+    bool setNote(size_t index, size_t noteIndex, float note)
+    {
+      Chords &edits = buffers[back];
+      if (index >= edits.numChords || noteIndex >= edits.chordSize(index))
+      {
+        return false;
+      }
+      size_t position = edits.offsets[index] + noteIndex;
+      edits.notes[position] = encodePitch(note);
+      publish({SIZE_MAX, position, position + 1});
+      return true;
+    }
+  };
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+
+namespace phnq
+{
+  /**
+   * @brief FIFO of values with a power-of-two capacity fixed by `init()`. Storage is
+   * allocated once in `init()`, so pushing and popping never allocate and are
+   * safe on the audio thread.
+   */
+  template <class T>
+  struct RingBuffer
+  {
+  private:
+    std::vector<T> items;
+    size_t mask = 0;
+    size_t head = 0; // Next item to pop.
+    size_t tail = 0; // Next slot to push.
+
+  public:
+    /**
+     * @brief Allocate storage and empty the buffer. Call at setup time, not from
+     * the audio thread.
+     *
+     * @param minCapacity number of items the buffer must be able to hold; rounded
+     * up to a power of two.
+     */
+    void init(size_t minCapacity)
+    {
+      size_t capacity = 1;
+      while (capacity < minCapacity)
+      {
+        capacity <<= 1;
+      }
+      items.assign(capacity, T());
+      mask = capacity - 1;
+      head = 0;
+      tail = 0;
+    }
+
+    size_t size()
+    {
+      return tail - head;
+    }
+
+    size_t capacity()
+    {
+      return items.size();
+    }
+
+    void clear()
+    {
+      head = tail;
+    }
+
+    /**
+     * @brief Add an item at the back. Returns false, leaving the buffer unchanged,
+     * if it is full.
+     */
+    bool push(const T &item)
+    {
+      if (size() == capacity())
+      {
+        return false;
+      }
+      items[tail++ & mask] = item;
+      return true;
+    }
+
+    /**
+     * @brief Remove the item at the front. Returns false if the buffer is empty.
+     */
+    bool pop(T &item)
+    {
+      if (head == tail)
+      {
+        return false;
+      }
+      item = items[head++ & mask];
+      return true;
+    }
+
+    /**
+     * @brief Add up to `numItems` items at the back, as many as fit.
+     *
+     * @return the number of items added.
+     */
+    size_t push(const T *block, size_t numItems)
+    {
+      size_t numPushed = capacity() - size();
+      numPushed = numItems < numPushed ? numItems : numPushed;
+      for (size_t i = 0; i < numPushed; i++)
+      {
+        items[tail++ & mask] = block[i];
+      }
+      return numPushed;
+    }
+
+    /**
+     * @brief Remove up to `numItems` items from the front into `block`.
+     *
+     * @return the number of items removed.
+     */
+    size_t pop(T *block, size_t numItems)
+    {
+      size_t numPopped = numItems < size() ? numItems : size();
+      for (size_t i = 0; i < numPopped; i++)
+      {
+        block[i] = items[head++ & mask];
+      }
+      return numPopped;
+    }
+  };
+}
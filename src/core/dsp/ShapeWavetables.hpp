@@ -0,0 +1,131 @@
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <vector>
+
+namespace phnq
+{
+  // Mip levels, one per octave. Level `i` plays frequencies up to 2^i/1024 cycles
+  // per sample with 512 >> i harmonics, so nothing is above Nyquist.
+  const size_t WAVETABLE_LEVELS = 10;
+  const float WAVETABLE_LEVEL_0_MAX_FREQUENCY = 1.f / 1024.f;
+  const size_t WAVETABLE_LEVEL_0_HARMONICS = 512;
+
+  // Samples per cycle are 4x the level's top harmonic, for linear interpolation,
+  // but at least this many.
+  const size_t WAVETABLE_MIN_SIZE = 64;
+
+  /**
+   * @brief Band-limited saw and triangle, one table per mip level. Together they
+   * cover `VariableShapeOscillator`'s whole waveshape range (at pulse width 0.5),
+   * because that morph is linear: triangle to saw over shape 0 to 0.5, then saw
+   * to square, and a square is a saw minus the same saw half a cycle on.
+   *
+   * Tables are generated on the heap by the first `get()`, so builds that never
+   * switch to them spend no RAM on them, and shared read-only by every voice of
+   * every instance. 34KB in all; call `get()` at setup time, not from the audio
+   * thread.
+   */
+  struct ShapeWavetables
+  {
+  private:
+    static size_t levelSize(size_t level)
+    {
+      size_t size = 4 * (WAVETABLE_LEVEL_0_HARMONICS >> level);
+      return size > WAVETABLE_MIN_SIZE ? size : WAVETABLE_MIN_SIZE;
+    }
+
+    static const size_t TOTAL_SIZE = 2048 + 1024 + 512 + 256 + 128 + 64 * 5 + WAVETABLE_LEVELS; // Plus a wrap sample per table.
+
+    float saws[TOTAL_SIZE];
+    float triangles[TOTAL_SIZE];
+    size_t offsets[WAVETABLE_LEVELS];
+    size_t sizes[WAVETABLE_LEVELS];
+
+    ShapeWavetables()
+    {
+      // One sine cycle at the largest size, which every level's size divides.
+      // Only needed while generating.
+      const size_t numSines = WAVETABLE_LEVEL_0_HARMONICS * 4;
+      std::vector<float> sines(numSines);
+      for (size_t i = 0; i < numSines; i++)
+      {
+        sines[i] = (float)sin(2.0 * M_PI * i / numSines);
+      }
+
+      size_t offset = 0;
+      for (size_t level = 0; level < WAVETABLE_LEVELS; level++)
+      {
+        size_t size = levelSize(level);
+        size_t numHarmonics = WAVETABLE_LEVEL_0_HARMONICS >> level;
+        size_t stride = numSines / size;
+        offsets[level] = offset;
+        sizes[level] = size;
+
+        // Fourier series of the bipolar naive waves: saw 2p - 1, and triangle
+        // from -1 at p = 0 up to 1 at p = 0.5. Harmonic k of sample j is at
+        // (k j mod size) / size of a cycle, looked up rather than computed.
+        for (size_t j = 0; j < size; j++)
+        {
+          double saw = 0.0, triangle = 0.0;
+          for (size_t k = 1; k <= numHarmonics; k++)
+          {
+            size_t index = (k * j) % size * stride;
+            saw -= sines[index] / (double)k;
+            if (k & 1)
+            {
+              triangle -= sines[(index + numSines / 4) % numSines] / ((double)k * k); // Cosine.
+            }
+          }
+          saws[offset + j] = (float)(saw * 2.0 / M_PI);
+          triangles[offset + j] = (float)(triangle * 8.0 / (M_PI * M_PI));
+        }
+        saws[offset + size] = saws[offset];
+        triangles[offset + size] = triangles[offset];
+        offset += size + 1;
+      }
+    }
+
+  public:
+    static const ShapeWavetables &get()
+    {
+      static const ShapeWavetables *tables = new ShapeWavetables();
+      return *tables;
+    }
+
+    /**
+     * @brief The mip level for `frequency` in cycles per sample.
+     */
+    static size_t levelFor(float frequency)
+    {
+      int exponent;
+      frexpf(frequency * (1.f / WAVETABLE_LEVEL_0_MAX_FREQUENCY), &exponent);
+      return exponent <= 0 ? 0 : exponent >= (int)WAVETABLE_LEVELS ? WAVETABLE_LEVELS - 1 : (size_t)exponent;
+    }
+
+    /**
+     * @brief Samples per cycle at `level`, a power of 2.
+     */
+    size_t size(size_t level) const
+    {
+      return sizes[level];
+    }
+
+    /**
+     * @brief `size(level) + 1` samples of one saw cycle; the last repeats the first.
+     */
+    const float *saw(size_t level) const
+    {
+      return &saws[offsets[level]];
+    }
+
+    /**
+     * @brief Same as `saw()` for the triangle.
+     */
+    const float *triangle(size_t level) const
+    {
+      return &triangles[offsets[level]];
+    }
+  };
+}
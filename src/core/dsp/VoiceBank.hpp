@@ -0,0 +1,503 @@
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include "../simd/Simd.hpp"
+#include "ShapeWavetables.hpp"
+
+namespace phnq
+{
+  const size_t MAX_BANK_VOICES = 16;
+
+  // Glide within this of the note counts as settled; a CV step, as in the engine.
+  const float GLIDE_SETTLE_THRESHOLD = 0.00001f;
+
+  const float VOICE_BANK_LANE_INDICES[8] = {0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f};
+
+  /**
+   * @brief Glided, detuned pairs of variable-shape oscillators, one pair per voice,
+   * run `simd::NATIVE_LANES` voices at a time. Each voice is a one-pole glide
+   * (as `daisysp::Port`) into a left and a right oscillator tuned a detune apart
+   * (as `daisysp::VariableShapeOscillator` without sync).
+   *
+   * State is kept as structure-of-arrays, one float per voice per field, so a
+   * group of voices loads into vectors, runs a whole block, and is stored back.
+   * Each voice's samples are bit-identical to the daisysp objects it replaces,
+   * and the mix sums voices in the same order, so the output is too (given no
+   * fused multiply-adds; see Simd.hpp).
+   *
+   * Voices past the count passed to `process()` that share a group with an active
+   * voice are computed, but their results and state are discarded, so they hold
+   * still like voices that aren't processed.
+   *
+   * With `setWavetable(true)` the oscillators instead read `ShapeWavetables`:
+   * the same waveshapes, band-limited by mip level rather than by polyBLEP, and
+   * always at pulse width 0.5. The table reads are per lane, so this is cheaper
+   * where lanes are scalar anyway (the Seed), but not where polyBLEP runs on a
+   * vector unit.
+   */
+  struct VoiceBank
+  {
+  private:
+    // Per-oscillator state: [0] for the left oscillators, [1] for the right.
+    alignas(16) float phase[2][MAX_BANK_VOICES] = {};
+    alignas(16) float nextSample[2][MAX_BANK_VOICES] = {};
+    alignas(16) float previousPw[2][MAX_BANK_VOICES] = {};
+    alignas(16) float high[2][MAX_BANK_VOICES] = {}; // Lane masks.
+    alignas(16) float frequency[2][MAX_BANK_VOICES] = {}; // Cycles per sample.
+    alignas(16) float pw[2][MAX_BANK_VOICES] = {};
+    alignas(16) float slopeUp[2][MAX_BANK_VOICES] = {};
+    alignas(16) float slopeDown[2][MAX_BANK_VOICES] = {};
+
+    // Per-voice state.
+    alignas(16) float notes[MAX_BANK_VOICES] = {};
+    alignas(16) float glided[MAX_BANK_VOICES] = {};
+    alignas(16) float tunedPitch[MAX_BANK_VOICES] = {}; // NAN to force a retune.
+    alignas(16) float tunedDetune[MAX_BANK_VOICES] = {};
+
+    float sampleRate = 48000.f;
+    float baseFrequency = 1.f;
+    float detune = 0.f;
+    float shape = 0.f;
+    float glideTime = 0.f;
+    float coefGlideTime = NAN; // Glide time the coefficients are for.
+    float glideCoef1 = 1.f;
+    float glideCoef2 = 0.f;
+    bool wavetable = false;
+    const ShapeWavetables *wavetables = NULL; // Fetched by the first `setWavetable(true)`.
+
+    typedef simd::NativeFloat V;
+
+    /**
+     * @brief Each lane's mip level tables for one group of oscillators.
+     */
+    struct LaneTables
+    {
+      const float *first[simd::NATIVE_LANES];
+      const float *second[simd::NATIVE_LANES];
+      alignas(16) float size[simd::NATIVE_LANES];
+      int secondOffset[simd::NATIVE_LANES]; // In samples.
+      int indexMask[simd::NATIVE_LANES];
+    };
+
+    /**
+     * @brief Oscillator state for one group of lanes, loaded into registers.
+     */
+    struct Group
+    {
+      V phase, nextSample, previousPw, high, frequency, pw, slopeUp, slopeDown;
+
+      void load(VoiceBank *bank, size_t side, size_t lane)
+      {
+        phase = V::load(&bank->phase[side][lane]);
+        nextSample = V::load(&bank->nextSample[side][lane]);
+        previousPw = V::load(&bank->previousPw[side][lane]);
+        high = V::load(&bank->high[side][lane]);
+        frequency = V::load(&bank->frequency[side][lane]);
+        pw = V::load(&bank->pw[side][lane]);
+        slopeUp = V::load(&bank->slopeUp[side][lane]);
+        slopeDown = V::load(&bank->slopeDown[side][lane]);
+      }
+
+      /**
+       * @brief Store the lanes set in `active`, leaving the others as they were.
+       * Tuning fields are stored by `retune()`.
+       */
+      void store(VoiceBank *bank, size_t side, size_t lane, V active)
+      {
+        simd::select(active, phase, V::load(&bank->phase[side][lane])).store(&bank->phase[side][lane]);
+        simd::select(active, nextSample, V::load(&bank->nextSample[side][lane])).store(&bank->nextSample[side][lane]);
+        simd::select(active, previousPw, V::load(&bank->previousPw[side][lane])).store(&bank->previousPw[side][lane]);
+        simd::select(active, high, V::load(&bank->high[side][lane])).store(&bank->high[side][lane]);
+      }
+    };
+
+    static V thisBlep(V t)
+    {
+      return V(0.5f) * t * t;
+    }
+
+    static V nextBlep(V t)
+    {
+      t = V(1.f) - t;
+      return V(-0.5f) * t * t;
+    }
+
+    static V nextIntegratedBlep(V t)
+    {
+      V t1 = V(0.5f) * t;
+      V t2 = t1 * t1;
+      V t4 = t2 * t2;
+      return V(0.1875f) - t1 + V(1.5f) * t2 - t4;
+    }
+
+    static V thisIntegratedBlep(V t)
+    {
+      return nextIntegratedBlep(V(1.f) - t);
+    }
+
+    /**
+     * @brief Where the phase has crossed the pulse width, step up the square and
+     * turn the triangle around.
+     */
+    static void rise(Group &osc, V &thisSample, V &nextSample, V squareAmount, V triangleAmount)
+    {
+      V rising = simd::andNot(osc.high, osc.phase >= osc.pw);
+      if (!simd::any(rising))
+      {
+        return;
+      }
+      V t = (osc.phase - osc.pw) / (osc.previousPw - osc.pw + osc.frequency);
+      V triangleStep = (osc.slopeUp + osc.slopeDown) * osc.frequency;
+      triangleStep *= triangleAmount;
+      V thisStepped = thisSample + squareAmount * thisBlep(t);
+      V nextStepped = nextSample + squareAmount * nextBlep(t);
+      thisStepped -= triangleStep * thisIntegratedBlep(t);
+      nextStepped -= triangleStep * nextIntegratedBlep(t);
+      thisSample = simd::select(rising, thisStepped, thisSample);
+      nextSample = simd::select(rising, nextStepped, nextSample);
+      osc.high = osc.high | rising;
+    }
+
+    /**
+     * @brief Where the phase has wrapped, step down the saw and square and turn the
+     * triangle around.
+     */
+    static void fall(Group &osc, V &thisSample, V &nextSample, V triangleAmount)
+    {
+      V falling = osc.high & (osc.phase >= V(1.f));
+      if (!simd::any(falling))
+      {
+        return;
+      }
+      osc.phase = simd::select(falling, osc.phase - V(1.f), osc.phase);
+      V t = osc.phase / osc.frequency;
+      V triangleStep = (osc.slopeUp + osc.slopeDown) * osc.frequency;
+      triangleStep *= triangleAmount;
+      V sawAmount = V(1.f) - triangleAmount;
+      V thisStepped = thisSample - sawAmount * thisBlep(t);
+      V nextStepped = nextSample - sawAmount * nextBlep(t);
+      thisStepped += triangleStep * thisIntegratedBlep(t);
+      nextStepped += triangleStep * nextIntegratedBlep(t);
+      thisSample = simd::select(falling, thisStepped, thisSample);
+      nextSample = simd::select(falling, nextStepped, nextSample);
+      osc.high = simd::andNot(falling, osc.high);
+    }
+
+    /**
+     * @brief One sample of each lane's oscillator, as `VariableShapeOscillator::Process()`.
+     */
+    static V processOscillators(Group &osc, V squareAmount, V triangleAmount)
+    {
+      V thisSample = osc.nextSample;
+      V nextSample(0.f);
+      osc.phase += osc.frequency;
+
+      // At most rise, fall, rise: after a wrap the phase is below the frequency,
+      // which is below the pulse width unless the frequency rose since `setPulseWidth()`.
+      rise(osc, thisSample, nextSample, squareAmount, triangleAmount);
+      fall(osc, thisSample, nextSample, triangleAmount);
+      rise(osc, thisSample, nextSample, squareAmount, triangleAmount);
+
+      V isLow = osc.phase < osc.pw;
+      V saw = osc.phase;
+      V square = simd::select(isLow, V(0.f), V(1.f));
+      V triangle = simd::select(isLow, osc.phase * osc.slopeUp, V(1.f) - (osc.phase - osc.pw) * osc.slopeDown);
+      saw += (square - saw) * squareAmount;
+      saw += (triangle - saw) * triangleAmount;
+      nextSample += saw;
+
+      osc.previousPw = osc.pw;
+      osc.nextSample = nextSample;
+      return V(2.f) * thisSample - V(1.f);
+    }
+
+    /**
+     * @brief Tune one side's oscillators to `frequencyHz`, as `SetSyncFreq()`.
+     */
+    void retune(Group &osc, size_t side, size_t lane, V frequencyHz, V active)
+    {
+      V cycles = frequencyHz / V(sampleRate);
+      V isFast = cycles >= V(0.25f);
+      V width = simd::select(isFast, V(0.5f), osc.pw);
+      cycles = simd::select(isFast, V(0.25f), cycles);
+
+      osc.frequency = simd::select(active, cycles, osc.frequency);
+      osc.pw = simd::select(active, width, osc.pw);
+      osc.slopeUp = V(1.f) / osc.pw;
+      osc.slopeDown = V(1.f) / (V(1.f) - osc.pw);
+      osc.frequency.store(&frequency[side][lane]);
+      osc.pw.store(&this->pw[side][lane]);
+      osc.slopeUp.store(&slopeUp[side][lane]);
+      osc.slopeDown.store(&slopeDown[side][lane]);
+    }
+
+    /**
+     * @brief Pick each lane's tables for its frequency: the saw, and either the
+     * triangle or, to make a square, the saw again.
+     */
+    void selectTables(const Group &osc, LaneTables &tables, bool square)
+    {
+      alignas(16) float frequencies[simd::NATIVE_LANES];
+      osc.frequency.store(frequencies);
+      for (size_t i = 0; i < simd::NATIVE_LANES; i++)
+      {
+        size_t level = ShapeWavetables::levelFor(frequencies[i]);
+        int size = (int)wavetables->size(level);
+        tables.first[i] = wavetables->saw(level);
+        tables.second[i] = square ? wavetables->saw(level) : wavetables->triangle(level);
+        tables.size[i] = (float)size;
+        tables.secondOffset[i] = square ? size / 2 : 0;
+        tables.indexMask[i] = size - 1;
+      }
+    }
+
+    /**
+     * @brief One sample of each active lane's oscillator from its tables: the saw
+     * times `firstAmount`, plus the second table, half a cycle on for a square,
+     * times `secondAmount`. Only the table reads are per lane.
+     */
+    static void readWavetables(Group &osc, const LaneTables &tables, float firstAmount, float secondAmount, size_t numActive, float *samples)
+    {
+      // Frequencies are at most 0.25, so one step never wraps twice.
+      osc.phase += osc.frequency;
+      osc.phase = simd::select(osc.phase >= V(1.f), osc.phase - V(1.f), osc.phase);
+
+      alignas(16) float positions[simd::NATIVE_LANES];
+      (osc.phase * V::load(tables.size)).store(positions);
+      for (size_t i = 0; i < numActive; i++)
+      {
+        // Sizes are powers of 2, so both reads share the interpolation fraction.
+        int index = (int)positions[i];
+        float fraction = positions[i] - (float)index;
+        const float *first = tables.first[i] + index;
+        const float *second = tables.second[i] + ((index + tables.secondOffset[i]) & tables.indexMask[i]);
+        samples[i] = firstAmount * (first[0] + (first[1] - first[0]) * fraction) +
+                     secondAmount * (second[0] + (second[1] - second[0]) * fraction);
+      }
+    }
+
+    void setOscillatorPw(size_t side, size_t voice, float pulseWidth)
+    {
+      float cycles = frequency[side][voice];
+      float width = cycles >= 0.25f ? 0.5f : fminf(fmaxf(pulseWidth, cycles * 2.f), 1.f - 2.f * cycles);
+      pw[side][voice] = width;
+      slopeUp[side][voice] = 1.f / width;
+      slopeDown[side][voice] = 1.f / (1.f - width);
+    }
+
+  public:
+    /**
+     * @brief Set the sample rate and reset every voice. Not for the audio thread
+     * while `process()` may run.
+     *
+     * @param baseFrequency frequency in Hz of pitch 0; pitches are 1/10 per octave.
+     */
+    void init(float sampleRate, float baseFrequency)
+    {
+      this->sampleRate = sampleRate;
+      this->baseFrequency = baseFrequency;
+      coefGlideTime = NAN;
+      for (size_t voice = 0; voice < MAX_BANK_VOICES; voice++)
+      {
+        initVoice(voice);
+      }
+    }
+
+    /**
+     * @brief Reset one voice's glide and oscillators, as re-initializing the
+     * daisysp objects would: phase 0, 220Hz until its next retune.
+     */
+    void initVoice(size_t voice)
+    {
+      for (size_t side = 0; side < 2; side++)
+      {
+        phase[side][voice] = 0.f;
+        nextSample[side][voice] = 0.f;
+        previousPw[side][voice] = 0.5f;
+        high[side][voice] = 0.f;
+        setOscillatorPw(side, voice, 0.f);
+        frequency[side][voice] = 220.f / sampleRate;
+      }
+      notes[voice] = 0.f;
+      glided[voice] = 0.f;
+      tunedPitch[voice] = NAN;
+      tunedDetune[voice] = 0.f;
+    }
+
+    void setNote(size_t voice, float note)
+    {
+      notes[voice] = note;
+    }
+
+    /**
+     * @brief Pitch offset of the left (down) and right (up) oscillators.
+     */
+    void setDetune(float detune)
+    {
+      this->detune = detune;
+    }
+
+    /**
+     * @brief Waveshape of every oscillator: 0 is triangle, 0.5 saw, 1 square.
+     */
+    void setShape(float shape)
+    {
+      this->shape = shape;
+    }
+
+    /**
+     * @brief Pulse width of every oscillator, clamped per oscillator to its current
+     * frequency as `SetPW()` does.
+     */
+    void setPulseWidth(float pulseWidth)
+    {
+      for (size_t voice = 0; voice < MAX_BANK_VOICES; voice++)
+      {
+        setOscillatorPw(0, voice, pulseWidth);
+        setOscillatorPw(1, voice, pulseWidth);
+      }
+    }
+
+    /**
+     * @brief Read the oscillators from band-limited wavetables instead of running
+     * polyBLEP oscillators. Phases carry over, so the pitch is continuous across
+     * a switch. The first switch to wavetables generates them if no bank has yet,
+     * so make it at setup time, not from the audio thread.
+     */
+    void setWavetable(bool wavetable)
+    {
+      if (wavetable && !wavetables)
+      {
+        wavetables = &ShapeWavetables::get();
+      }
+      this->wavetable = wavetable;
+    }
+
+    /**
+     * @brief Glide half-time in seconds, shared by every voice.
+     */
+    void setGlideTime(float glideTime)
+    {
+      this->glideTime = glideTime;
+    }
+
+    /**
+     * @brief Run the first `numVoices` voices for `numFrames` frames, adding each
+     * voice's left and right samples, in voice order, to `left` and `right`.
+     *
+     * @param voicesLeft if not NULL, receives each voice's last left sample.
+     * @param voicesRight same as `voicesLeft` for the right oscillators.
+     */
+    void process(size_t numVoices, float *left, float *right, size_t numFrames, float *voicesLeft, float *voicesRight)
+    {
+      if (glideTime != coefGlideTime)
+      {
+        glideCoef2 = powf(0.5f, (1.f / sampleRate) / glideTime);
+        glideCoef1 = 1.f - glideCoef2;
+        coefGlideTime = glideTime;
+      }
+
+      float square = fmaxf(shape - 0.5f, 0.f) * 2.f;
+      float triangle = fmaxf(1.f - shape * 2.f, 0.f);
+      const V squareAmount(square);
+      const V triangleAmount(triangle);
+      const V glideCoef1(this->glideCoef1);
+      const V glideCoef2(this->glideCoef2);
+      const V detune(this->detune);
+      const V pitchScale(10.f);
+
+      // The wavetable morph: the saw less the triangle amount, plus either the
+      // triangle or, for a square, minus the saw half a cycle on.
+      bool isSquare = square > 0.f;
+      float firstAmount = 1.f - triangle;
+      float secondAmount = isSquare ? -square : triangle;
+
+      for (size_t lane = 0; lane < numVoices; lane += simd::NATIVE_LANES)
+      {
+        size_t numActive = numVoices - lane;
+        if (numActive > simd::NATIVE_LANES)
+        {
+          numActive = simd::NATIVE_LANES;
+        }
+        V active = V::load(VOICE_BANK_LANE_INDICES) < V((float)numActive);
+
+        Group osc1, osc2;
+        osc1.load(this, 0, lane);
+        osc2.load(this, 1, lane);
+        V note = V::load(&notes[lane]);
+        V glidedPitch = V::load(&glided[lane]);
+        V tunedPitch = V::load(&this->tunedPitch[lane]);
+        V tunedDetune = V::load(&this->tunedDetune[lane]);
+
+        LaneTables tables1, tables2;
+        if (wavetable)
+        {
+          selectTables(osc1, tables1, isSquare);
+          selectTables(osc2, tables2, isSquare);
+        }
+
+        alignas(16) float samples1[simd::NATIVE_LANES], samples2[simd::NATIVE_LANES];
+        for (size_t frame = 0; frame < numFrames; frame++)
+        {
+          // Once glide has settled (to within a CV step of the note, or where the
+          // one-pole stalls short of it), the oscillators keep their frequencies.
+          glidedPitch = glideCoef1 * note + glideCoef2 * glidedPitch;
+          V pitch = simd::select(simd::abs(glidedPitch - note) < V(GLIDE_SETTLE_THRESHOLD), note, glidedPitch);
+          // Equal both ways is false for NAN, which forces a retune.
+          V tuned = (pitch <= tunedPitch) & (pitch >= tunedPitch) & (detune <= tunedDetune) & (detune >= tunedDetune);
+          V changed = simd::andNot(tuned, active);
+          if (simd::any(changed))
+          {
+            retune(osc1, 0, lane, V(baseFrequency) * simd::fastExp2((pitch - detune) * pitchScale), changed);
+            retune(osc2, 1, lane, V(baseFrequency) * simd::fastExp2((pitch + detune) * pitchScale), changed);
+            tunedPitch = simd::select(changed, pitch, tunedPitch);
+            tunedDetune = simd::select(changed, detune, tunedDetune);
+            if (wavetable)
+            {
+              selectTables(osc1, tables1, isSquare);
+              selectTables(osc2, tables2, isSquare);
+            }
+          }
+
+          if (wavetable)
+          {
+            readWavetables(osc1, tables1, firstAmount, secondAmount, numActive, samples1);
+            readWavetables(osc2, tables2, firstAmount, secondAmount, numActive, samples2);
+          }
+          else
+          {
+            processOscillators(osc1, squareAmount, triangleAmount).store(samples1);
+            processOscillators(osc2, squareAmount, triangleAmount).store(samples2);
+          }
+          for (size_t i = 0; i < numActive; i++)
+          {
+            left[frame] += samples1[i];
+            right[frame] += samples2[i];
+          }
+        }
+
+        if (wavetable)
+        {
+          // So the polyBLEP oscillators pick up where the tables left off.
+          osc1.high = osc1.phase >= osc1.pw;
+          osc2.high = osc2.phase >= osc2.pw;
+        }
+        osc1.store(this, 0, lane, active);
+        osc2.store(this, 1, lane, active);
+        simd::select(active, glidedPitch, V::load(&glided[lane])).store(&glided[lane]);
+        tunedPitch.store(&this->tunedPitch[lane]);
+        tunedDetune.store(&this->tunedDetune[lane]);
+
+        if (voicesLeft && numFrames > 0)
+        {
+          for (size_t i = 0; i < numActive; i++)
+          {
+            voicesLeft[lane + i] = samples1[i];
+            voicesRight[lane + i] = samples2[i];
+          }
+        }
+      }
+    }
+  };
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <stddef.h>
+
+namespace phnq
+{
+  /**
+   * @brief Assigns chord notes to a fixed number of preallocated voices. Voices
+   * are only activated and deactivated, so the work per sample is bounded by
+   * `getMaxVoices()` however many notes a chord has.
+   *
+   * Stealing is deterministic: note `i` of a chord plays on voice `i % maxVoices`,
+   * so once a chord has more notes than voices, each note added takes over the
+   * voice of the oldest note still sounding, and the newest `maxVoices` notes
+   * sound. Chords within the limit map note `i` to voice `i`.
+   */
+  struct VoicePool
+  {
+  private:
+    size_t maxVoices = 1;
+    size_t numActive = 0;
+
+  public:
+    /**
+     * @param maxVoices number of voices the owner has preallocated; at least 1.
+     */
+    VoicePool(size_t maxVoices)
+    {
+      setMaxVoices(maxVoices);
+    }
+
+    size_t getMaxVoices()
+    {
+      return maxVoices;
+    }
+
+    /**
+     * @brief Change the polyphony, up to what the owner has preallocated. Voices
+     * above it are deactivated.
+     */
+    void setMaxVoices(size_t maxVoices)
+    {
+      this->maxVoices = maxVoices > 0 ? maxVoices : 1;
+      if (numActive > this->maxVoices)
+      {
+        numActive = this->maxVoices;
+      }
+    }
+
+    size_t getNumActive()
+    {
+      return numActive;
+    }
+
+    /**
+     * @brief Activate enough voices for the largest chord, `maxNotes`, and
+     * deactivate the rest.
+     *
+     * @return the first newly activated voice; voices from it up to
+     * `getNumActive()` need to be reset by the owner.
+     */
+    size_t activate(size_t maxNotes)
+    {
+      size_t firstNew = numActive;
+      numActive = maxNotes < maxVoices ? maxNotes : maxVoices;
+      return firstNew;
+    }
+
+    /**
+     * @brief Number of voices a chord of `numNotes` notes sounds on.
+     */
+    size_t numVoicesFor(size_t numNotes)
+    {
+      size_t numVoices = numNotes < maxVoices ? numNotes : maxVoices;
+      return numVoices < numActive ? numVoices : numActive;
+    }
+
+    /**
+     * @brief Index of the note `voice` plays in a chord of `numNotes` notes: the
+     * newest one assigned to it.
+     */
+    size_t noteForVoice(size_t voice, size_t numNotes)
+    {
+      return voice + (numNotes - 1 - voice) / maxVoices * maxVoices;
+    }
+  };
+}
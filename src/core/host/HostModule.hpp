@@ -0,0 +1,91 @@
+#pragma once
+
+/**
+ * Host adapter for engines built on the legacy `phnq::Engine`. Input ports are
+ * driven by panel id from a timeline script (see `core2/host/Host.hpp`), and the
+ * Audio and CV output ports are written to the output file, one channel per port,
+ * in the order they were added. The engine is run one frame at a time.
+ */
+
+#include <map>
+#include "../Engine.hpp"
+#include "../../core2/host/Host.hpp"
+
+extern phnq::Engine *moduleInstance;
+
+int main(int argc, char **argv)
+{
+  phnq::host::Options options;
+  if (!phnq::host::parseOptions(argc, argv, options))
+  {
+    return 1;
+  }
+
+  std::vector<phnq::host::TimelineEvent> timeline;
+  if (!options.scriptPath.empty() && !phnq::host::loadTimeline(options.scriptPath, options.sampleRate, timeline))
+  {
+    return 1;
+  }
+
+  phnq::FrameInfo frameInfo = {options.sampleRate, 1.f / options.sampleRate};
+
+  std::map<std::string, phnq::IOPort *> inputsById;
+  std::vector<phnq::IOPort *> outputs;
+  for (phnq::IOPort *ioPort : moduleInstance->getIOPorts())
+  {
+    if (ioPort->getDirection() == phnq::IOPortDirection::Input)
+    {
+      inputsById[ioPort->getPanelId()] = ioPort;
+    }
+    else if (ioPort->getType() == phnq::IOPortType::Audio || ioPort->getType() == phnq::IOPortType::CV)
+    {
+      outputs.push_back(ioPort);
+    }
+  }
+
+  // Resolve port ids up front so the render loop does no lookups.
+  std::vector<phnq::IOPort *> eventInputs;
+  for (const phnq::host::TimelineEvent &event : timeline)
+  {
+    std::map<std::string, phnq::IOPort *>::iterator it = inputsById.find(event.portId);
+    if (it == inputsById.end())
+    {
+      fprintf(stderr, "No input port with id \"%s\"\n", event.portId.c_str());
+      return 1;
+    }
+    eventInputs.push_back(it->second);
+  }
+
+  uint64_t numFrames = (uint64_t)(options.duration * options.sampleRate);
+  size_t numChannels = outputs.size();
+  std::vector<float> output(options.outPath.empty() ? 0 : numFrames * numChannels);
+
+  phnq::host::Stopwatch stopwatch;
+
+  size_t eventIndex = 0;
+  for (uint64_t frame = 0; frame < numFrames; frame++)
+  {
+    for (; eventIndex < timeline.size() && timeline[eventIndex].frame <= frame; eventIndex++)
+    {
+      eventInputs[eventIndex]->setValue(timeline[eventIndex].value);
+    }
+
+    moduleInstance->doProcess(frameInfo);
+
+    if (!output.empty())
+    {
+      for (size_t i = 0; i < numChannels; i++)
+      {
+        output[frame * numChannels + i] = outputs[i]->getValue();
+      }
+    }
+  }
+
+  phnq::host::reportTiming(numFrames, options.sampleRate, stopwatch.getElapsedNanos());
+
+  if (!options.outPath.empty() && !phnq::host::writeOutput(options, numChannels, output))
+  {
+    return 1;
+  }
+  return 0;
+}
@@ -10,10 +10,16 @@ using namespace std;
 
 namespace phnq
 {
-  struct PortMapping
+  /**
+   * @brief Connects an engine port to a Rack param, input, output or light. The Rack
+   * value is `scale` times the port value for outputs, and the port value is
+   * `scale` times the Rack value for inputs.
+   */
+  struct PortBinding
   {
-    unsigned int id;
     IOPort *port;
+    unsigned int index;
+    float scale;
   };
 
   template <class TEngine = phnq::Engine>
@@ -21,7 +27,62 @@ namespace phnq
   {
   private:
     phnq::Engine *engine;
-    vector<PortMapping> portMappings;
+    vector<PortBinding> paramBindings;
+    vector<PortBinding> inputBindings;
+    vector<PortBinding> outputBindings;
+    vector<PortBinding> lightBindings;
+
+    /**
+     * @brief Build the binding tables. Rack indexes are assigned per kind in port
+     * order, the same order RackModuleUI creates its widgets in.
+     */
+    void bindPorts()
+    {
+      for (IOPort *port : engine->getIOPorts())
+      {
+        bool isInput = port->getDirection() == IOPortDirection::Input;
+        switch (port->getType())
+        {
+        case IOPortType::Audio:
+          // [-5, 5] <-> [-1, 1]
+          if (isInput)
+          {
+            inputBindings.push_back({port, (unsigned int)inputBindings.size(), 1.f / 5.f});
+          }
+          else
+          {
+            outputBindings.push_back({port, (unsigned int)outputBindings.size(), 5.f});
+          }
+          break;
+        case IOPortType::CV:
+        case IOPortType::Gate:
+          // [0, 10] <-> [0, 1]
+          if (isInput)
+          {
+            inputBindings.push_back({port, (unsigned int)inputBindings.size(), 1.f / 10.f});
+          }
+          else
+          {
+            outputBindings.push_back({port, (unsigned int)outputBindings.size(), 10.f});
+          }
+          break;
+        case IOPortType::Param:
+        case IOPortType::Button:
+          // [0, 1] <-> [0, 1]
+          if (isInput)
+          {
+            paramBindings.push_back({port, (unsigned int)paramBindings.size(), 1.f});
+          }
+          break;
+        case IOPortType::Led:
+          if (!isInput)
+          {
+            lightBindings.push_back({port, (unsigned int)lightBindings.size(), 1.f});
+          }
+          break;
+        }
+      }
+    }
 
   public:
     RackModule()
@@ -29,6 +90,7 @@ namespace phnq
       engine = new TEngine();
       IOConfig ioConfig = engine->getIOConfig();
       config(ioConfig.numParams + ioConfig.numButtons, ioConfig.numAudioIns + ioConfig.numCVIns + ioConfig.numGateIns, ioConfig.numAudioOuts + ioConfig.numCVOuts + ioConfig.numGateOuts, ioConfig.numLeds);
+      bindPorts();
     }
 
     ~RackModule()
@@ -41,45 +103,18 @@ namespace phnq
       return (TEngine *)this->engine;
     }
 
-    void addPortMapping(unsigned int id, IOPort *port)
-    {
-      portMappings.push_back({id, port});
-    }
-
     void process(const ProcessArgs &args) override
     {
       /**
-       * Perpare the input values for the module engine by querying the module host:
-       * - Audio input port values are set.
-       * - Param values are set on corresponding ports.
-       * - CV input port values are set.
-       * - Gate input port values are set.
+       * Perpare the input values for the module engine by querying the module host.
        */
-      for (vector<PortMapping>::iterator it = portMappings.begin(); it != portMappings.end(); it++)
+      for (const PortBinding &binding : paramBindings)
       {
-        if (it->port->getDirection() == IOPortDirection::Input)
-        {
-          switch (it->port->getType())
-          {
-          case IOPortType::Audio:
-            // [-5, 5] -> [-1, 1] -- divide by 5.
-            it->port->setValue(inputs[it->id].getVoltage() / 5.f);
-            break;
-          case IOPortType::Param:
-          case IOPortType::Button:
-            // [0, 1] -> [0, 1] -- nothing to be done.
-            it->port->setValue(params[it->id].getValue());
-            break;
-          case IOPortType::CV:
-          case IOPortType::Gate:
-            // [0, 10] -> [0, 1] -- divide by 10.
-            it->port->setValue(inputs[it->id].getVoltage() / 10.f);
-            break;
-          case IOPortType::Led:
-            // N/A
-            break;
-          }
-        }
+        binding.port->setValue(params[binding.index].getValue() * binding.scale);
+      }
+      for (const PortBinding &binding : inputBindings)
+      {
+        binding.port->setValue(inputs[binding.index].getVoltage() * binding.scale);
       }
 
       /**
@@ -88,36 +123,15 @@ namespace phnq
       engine->doProcess({args.sampleRate, args.sampleTime});
 
       /**
-       * Take the output values that were set in `engine->doProcess()` and send them to the module host:
-       * - Audio
-       * - CV
-       * - Gate
+       * Take the output values that were set in `engine->doProcess()` and send them to the module host.
        */
-      for (vector<PortMapping>::iterator it = portMappings.begin(); it != portMappings.end(); it++)
+      for (const PortBinding &binding : outputBindings)
       {
-        if (it->port->getDirection() == IOPortDirection::Output)
-        {
-          switch (it->port->getType())
-          {
-          case IOPortType::Audio:
-            // [-1, 1] -> [-5, 5] -- multiply by 5.
-            outputs[it->id].setVoltage(it->port->getValue() * 5.f);
-            break;
-          case IOPortType::CV:
-          case IOPortType::Gate:
-            // [0, 1] -> [0, 10] -- multiply by 10.
-            outputs[it->id].setVoltage(it->port->getValue() * 10.f);
-            break;
-          case IOPortType::Led:
-            lights[it->id].setBrightness(it->port->getValue());
-            break;
-
-          case IOPortType::Param:
-          case IOPortType::Button:
-            // N/A
-            break;
-          }
-        }
+        outputs[binding.index].setVoltage(binding.port->getValue() * binding.scale);
+      }
+      for (const PortBinding &binding : lightBindings)
+      {
+        lights[binding.index].setBrightness(binding.port->getValue() * binding.scale);
       }
     }
   };
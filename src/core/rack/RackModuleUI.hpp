@@ -64,13 +64,11 @@ namespace phnq
             if (ioPort->getDirection() == IOPortDirection::Input)
             {
               addInput(createInputCentered<PJ301MPort>(mm2px(Vec(cx, cy)), module, inputIndex));
-              module->addPortMapping(inputIndex, ioPort);
               inputIndex++;
             }
             else if (ioPort->getDirection() == IOPortDirection::Output)
             {
               addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(cx, cy)), module, outputIndex));
-              module->addPortMapping(outputIndex, ioPort);
               outputIndex++;
             }
             break;
@@ -78,7 +76,6 @@ namespace phnq
             if (ioPort->getDirection() == IOPortDirection::Input)
             {
               addParam(createParamCentered<RoundBlackKnob>(mm2px(Vec(cx, cy)), module, paramIndex));
-              module->addPortMapping(paramIndex, ioPort);
               paramIndex++;
             }
             break;
@@ -86,7 +83,6 @@ namespace phnq
             if (ioPort->getDirection() == IOPortDirection::Input)
             {
               addParam(createParamCentered<VCVButton>(mm2px(Vec(cx, cy)), module, paramIndex));
-              module->addPortMapping(paramIndex, ioPort);
               paramIndex++;
             }
             break;
@@ -94,7 +90,6 @@ namespace phnq
             if (ioPort->getDirection() == IOPortDirection::Output)
             {
               addChild(createLightCentered<MediumLight<RedLight>>(mm2px(Vec(cx, cy)), module, ledIndex));
-              module->addPortMapping(ledIndex, ioPort);
               ledIndex++;
             }
             break;
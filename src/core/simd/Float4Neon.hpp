@@ -0,0 +1,157 @@
+#pragma once
+
+#include <stdint.h>
+#include <arm_neon.h>
+
+namespace phnq
+{
+  namespace simd
+  {
+    /**
+     * @brief Four float lanes in a NEON register (AArch64 hosts, e.g. Rack on
+     * Apple silicon).
+     */
+    struct Float4
+    {
+      float32x4_t v;
+
+      Float4() : v(vdupq_n_f32(0.f))
+      {
+      }
+
+      Float4(float value) : v(vdupq_n_f32(value))
+      {
+      }
+
+      Float4(float32x4_t v) : v(v)
+      {
+      }
+
+      static Float4 load(const float *in)
+      {
+        return Float4(vld1q_f32(in));
+      }
+
+      void store(float *out) const
+      {
+        vst1q_f32(out, v);
+      }
+
+      float operator[](size_t lane) const
+      {
+        float lanes[4];
+        store(lanes);
+        return lanes[lane];
+      }
+    };
+
+    inline Float4 operator+(Float4 a, Float4 b)
+    {
+      return vaddq_f32(a.v, b.v);
+    }
+
+    inline Float4 operator-(Float4 a, Float4 b)
+    {
+      return vsubq_f32(a.v, b.v);
+    }
+
+    inline Float4 operator*(Float4 a, Float4 b)
+    {
+      return vmulq_f32(a.v, b.v);
+    }
+
+    inline Float4 operator/(Float4 a, Float4 b)
+    {
+      return vdivq_f32(a.v, b.v);
+    }
+
+    inline Float4 operator-(Float4 a)
+    {
+      return vnegq_f32(a.v);
+    }
+
+    inline Float4 operator<(Float4 a, Float4 b)
+    {
+      return vreinterpretq_f32_u32(vcltq_f32(a.v, b.v));
+    }
+
+    inline Float4 operator<=(Float4 a, Float4 b)
+    {
+      return vreinterpretq_f32_u32(vcleq_f32(a.v, b.v));
+    }
+
+    inline Float4 operator>(Float4 a, Float4 b)
+    {
+      return vreinterpretq_f32_u32(vcgtq_f32(a.v, b.v));
+    }
+
+    inline Float4 operator>=(Float4 a, Float4 b)
+    {
+      return vreinterpretq_f32_u32(vcgeq_f32(a.v, b.v));
+    }
+
+    inline Float4 operator&(Float4 a, Float4 b)
+    {
+      return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a.v), vreinterpretq_u32_f32(b.v)));
+    }
+
+    inline Float4 operator|(Float4 a, Float4 b)
+    {
+      return vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(a.v), vreinterpretq_u32_f32(b.v)));
+    }
+
+    inline Float4 andNot(Float4 mask, Float4 a)
+    {
+      return vreinterpretq_f32_u32(vbicq_u32(vreinterpretq_u32_f32(a.v), vreinterpretq_u32_f32(mask.v)));
+    }
+
+    inline bool any(Float4 mask)
+    {
+      return vmaxvq_u32(vreinterpretq_u32_f32(mask.v)) != 0;
+    }
+
+    inline Float4 select(Float4 mask, Float4 a, Float4 b)
+    {
+      return vbslq_f32(vreinterpretq_u32_f32(mask.v), a.v, b.v);
+    }
+
+    // vminq/vmaxq propagate NaN; comparing first matches the other backends.
+    inline Float4 min(Float4 a, Float4 b)
+    {
+      return select(a < b, a, b);
+    }
+
+    inline Float4 max(Float4 a, Float4 b)
+    {
+      return select(a > b, a, b);
+    }
+
+    inline Float4 abs(Float4 a)
+    {
+      return vabsq_f32(a.v);
+    }
+
+    inline Float4 floor(Float4 a)
+    {
+      return vrndmq_f32(a.v);
+    }
+
+    inline Float4 sqrt(Float4 a)
+    {
+      return vsqrtq_f32(a.v);
+    }
+
+    inline Float4 exp2Int(Float4 whole)
+    {
+      Float4 clamped = min(max(whole, Float4(-126.f)), Float4(127.f));
+      int32x4_t exponent = vaddq_s32(vcvtq_s32_f32(clamped.v), vdupq_n_s32(127));
+      return vreinterpretq_f32_s32(vshlq_n_s32(exponent, 23));
+    }
+
+    inline float sum(Float4 a)
+    {
+      float32x2_t pairs = vadd_f32(vget_low_f32(a.v), vget_high_f32(a.v)); // 0+2, 1+3
+      return vget_lane_f32(vpadd_f32(pairs, pairs), 0);
+    }
+  }
+}
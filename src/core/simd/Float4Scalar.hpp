@@ -0,0 +1,229 @@
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace phnq
+{
+  namespace simd
+  {
+    /**
+     * @brief Four float lanes as a plain array, for targets without float vector
+     * units (the Seed's Cortex-M7) and as the reference the vector backends are
+     * checked against. Every operation is the lane-wise scalar expression.
+     */
+    struct Float4
+    {
+      float lanes[4];
+
+      Float4() : lanes()
+      {
+      }
+
+      Float4(float value)
+      {
+        lanes[0] = lanes[1] = lanes[2] = lanes[3] = value;
+      }
+
+      static Float4 load(const float *in)
+      {
+        Float4 v;
+        memcpy(v.lanes, in, sizeof(v.lanes));
+        return v;
+      }
+
+      void store(float *out) const
+      {
+        memcpy(out, lanes, sizeof(lanes));
+      }
+
+      float operator[](size_t lane) const
+      {
+        return lanes[lane];
+      }
+    };
+
+    namespace scalar
+    {
+      inline uint32_t toBits(float value)
+      {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return bits;
+      }
+
+      inline float fromBits(uint32_t bits)
+      {
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+      }
+
+      inline float mask(bool condition)
+      {
+        return fromBits(condition ? 0xFFFFFFFFu : 0u);
+      }
+    }
+
+#define PHNQ_SIMD_SCALAR_OP(op)                                  \
+  inline Float4 operator op(Float4 a, Float4 b)                  \
+  {                                                              \
+    Float4 r;                                                    \
+    for (size_t i = 0; i < 4; i++)                               \
+    {                                                            \
+      r.lanes[i] = a.lanes[i] op b.lanes[i];                     \
+    }                                                            \
+    return r;                                                    \
+  }
+
+#define PHNQ_SIMD_SCALAR_COMPARE(op)                             \
+  inline Float4 operator op(Float4 a, Float4 b)                  \
+  {                                                              \
+    Float4 r;                                                    \
+    for (size_t i = 0; i < 4; i++)                               \
+    {                                                            \
+      r.lanes[i] = scalar::mask(a.lanes[i] op b.lanes[i]);       \
+    }                                                            \
+    return r;                                                    \
+  }
+
+    PHNQ_SIMD_SCALAR_OP(+)
+    PHNQ_SIMD_SCALAR_OP(-)
+    PHNQ_SIMD_SCALAR_OP(*)
+    PHNQ_SIMD_SCALAR_OP(/)
+    PHNQ_SIMD_SCALAR_COMPARE(<)
+    PHNQ_SIMD_SCALAR_COMPARE(<=)
+    PHNQ_SIMD_SCALAR_COMPARE(>)
+    PHNQ_SIMD_SCALAR_COMPARE(>=)
+
+#undef PHNQ_SIMD_SCALAR_OP
+#undef PHNQ_SIMD_SCALAR_COMPARE
+
+    inline Float4 operator-(Float4 a)
+    {
+      Float4 r;
+      for (size_t i = 0; i < 4; i++)
+      {
+        r.lanes[i] = -a.lanes[i];
+      }
+      return r;
+    }
+
+    inline Float4 min(Float4 a, Float4 b)
+    {
+      Float4 r;
+      for (size_t i = 0; i < 4; i++)
+      {
+        r.lanes[i] = a.lanes[i] < b.lanes[i] ? a.lanes[i] : b.lanes[i];
+      }
+      return r;
+    }
+
+    inline Float4 max(Float4 a, Float4 b)
+    {
+      Float4 r;
+      for (size_t i = 0; i < 4; i++)
+      {
+        r.lanes[i] = a.lanes[i] > b.lanes[i] ? a.lanes[i] : b.lanes[i];
+      }
+      return r;
+    }
+
+    inline Float4 abs(Float4 a)
+    {
+      Float4 r;
+      for (size_t i = 0; i < 4; i++)
+      {
+        r.lanes[i] = fabsf(a.lanes[i]);
+      }
+      return r;
+    }
+
+    inline Float4 floor(Float4 a)
+    {
+      Float4 r;
+      for (size_t i = 0; i < 4; i++)
+      {
+        r.lanes[i] = floorf(a.lanes[i]);
+      }
+      return r;
+    }
+
+    inline Float4 sqrt(Float4 a)
+    {
+      Float4 r;
+      for (size_t i = 0; i < 4; i++)
+      {
+        r.lanes[i] = sqrtf(a.lanes[i]);
+      }
+      return r;
+    }
+
+    inline Float4 select(Float4 mask, Float4 a, Float4 b)
+    {
+      Float4 r;
+      for (size_t i = 0; i < 4; i++)
+      {
+        r.lanes[i] = scalar::toBits(mask.lanes[i]) ? a.lanes[i] : b.lanes[i];
+      }
+      return r;
+    }
+
+    inline Float4 exp2Int(Float4 whole)
+    {
+      Float4 r;
+      for (size_t i = 0; i < 4; i++)
+      {
+        float clamped = whole.lanes[i] < -126.f ? -126.f : whole.lanes[i] > 127.f ? 127.f : whole.lanes[i];
+        r.lanes[i] = scalar::fromBits((uint32_t)((int32_t)clamped + 127) << 23);
+      }
+      return r;
+    }
+
+    inline Float4 operator&(Float4 a, Float4 b)
+    {
+      Float4 r;
+      for (size_t i = 0; i < 4; i++)
+      {
+        r.lanes[i] = scalar::fromBits(scalar::toBits(a.lanes[i]) & scalar::toBits(b.lanes[i]));
+      }
+      return r;
+    }
+
+    inline Float4 operator|(Float4 a, Float4 b)
+    {
+      Float4 r;
+      for (size_t i = 0; i < 4; i++)
+      {
+        r.lanes[i] = scalar::fromBits(scalar::toBits(a.lanes[i]) | scalar::toBits(b.lanes[i]));
+      }
+      return r;
+    }
+
+    inline Float4 andNot(Float4 mask, Float4 a)
+    {
+      Float4 r;
+      for (size_t i = 0; i < 4; i++)
+      {
+        r.lanes[i] = scalar::fromBits(~scalar::toBits(mask.lanes[i]) & scalar::toBits(a.lanes[i]));
+      }
+      return r;
+    }
+
+    inline bool any(Float4 mask)
+    {
+      bool result = false;
+      for (size_t i = 0; i < 4; i++)
+      {
+        result |= scalar::toBits(mask.lanes[i]) != 0;
+      }
+      return result;
+    }
+
+    inline float sum(Float4 a)
+    {
+      return (a.lanes[0] + a.lanes[2]) + (a.lanes[1] + a.lanes[3]);
+    }
+  }
+}
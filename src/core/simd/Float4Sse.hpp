@@ -0,0 +1,162 @@
+#pragma once
+
+#include <stdint.h>
+#include <emmintrin.h>
+
+namespace phnq
+{
+  namespace simd
+  {
+    /**
+     * @brief Four float lanes in an SSE2 register (any x86-64 host).
+     */
+    struct Float4
+    {
+      __m128 v;
+
+      Float4() : v(_mm_setzero_ps())
+      {
+      }
+
+      Float4(float value) : v(_mm_set1_ps(value))
+      {
+      }
+
+      Float4(__m128 v) : v(v)
+      {
+      }
+
+      static Float4 load(const float *in)
+      {
+        return Float4(_mm_loadu_ps(in));
+      }
+
+      void store(float *out) const
+      {
+        _mm_storeu_ps(out, v);
+      }
+
+      float operator[](size_t lane) const
+      {
+        float lanes[4];
+        store(lanes);
+        return lanes[lane];
+      }
+    };
+
+    inline Float4 operator+(Float4 a, Float4 b)
+    {
+      return _mm_add_ps(a.v, b.v);
+    }
+
+    inline Float4 operator-(Float4 a, Float4 b)
+    {
+      return _mm_sub_ps(a.v, b.v);
+    }
+
+    inline Float4 operator*(Float4 a, Float4 b)
+    {
+      return _mm_mul_ps(a.v, b.v);
+    }
+
+    inline Float4 operator/(Float4 a, Float4 b)
+    {
+      return _mm_div_ps(a.v, b.v);
+    }
+
+    inline Float4 operator-(Float4 a)
+    {
+      return _mm_xor_ps(a.v, _mm_set1_ps(-0.f));
+    }
+
+    inline Float4 operator<(Float4 a, Float4 b)
+    {
+      return _mm_cmplt_ps(a.v, b.v);
+    }
+
+    inline Float4 operator<=(Float4 a, Float4 b)
+    {
+      return _mm_cmple_ps(a.v, b.v);
+    }
+
+    inline Float4 operator>(Float4 a, Float4 b)
+    {
+      return _mm_cmpgt_ps(a.v, b.v);
+    }
+
+    inline Float4 operator>=(Float4 a, Float4 b)
+    {
+      return _mm_cmpge_ps(a.v, b.v);
+    }
+
+    inline Float4 min(Float4 a, Float4 b)
+    {
+      return _mm_min_ps(a.v, b.v);
+    }
+
+    inline Float4 max(Float4 a, Float4 b)
+    {
+      return _mm_max_ps(a.v, b.v);
+    }
+
+    inline Float4 abs(Float4 a)
+    {
+      return _mm_andnot_ps(_mm_set1_ps(-0.f), a.v);
+    }
+
+    inline Float4 floor(Float4 a)
+    {
+      // SSE2 has no rounding instruction: truncate, step down where that rounded
+      // up, and keep the sign so -0 stays -0. Lanes of 2^23 and up are already
+      // whole (and may not fit an int32).
+      __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(a.v));
+      __m128 floored = _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, a.v), _mm_set1_ps(1.f)));
+      floored = _mm_or_ps(floored, _mm_and_ps(a.v, _mm_set1_ps(-0.f)));
+      __m128 isWhole = _mm_cmpge_ps(_mm_andnot_ps(_mm_set1_ps(-0.f), a.v), _mm_set1_ps(8388608.f));
+      return _mm_or_ps(_mm_and_ps(isWhole, a.v), _mm_andnot_ps(isWhole, floored));
+    }
+
+    inline Float4 sqrt(Float4 a)
+    {
+      return _mm_sqrt_ps(a.v);
+    }
+
+    inline Float4 select(Float4 mask, Float4 a, Float4 b)
+    {
+      return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v));
+    }
+
+    inline Float4 operator&(Float4 a, Float4 b)
+    {
+      return _mm_and_ps(a.v, b.v);
+    }
+
+    inline Float4 operator|(Float4 a, Float4 b)
+    {
+      return _mm_or_ps(a.v, b.v);
+    }
+
+    inline Float4 andNot(Float4 mask, Float4 a)
+    {
+      return _mm_andnot_ps(mask.v, a.v);
+    }
+
+    inline bool any(Float4 mask)
+    {
+      return _mm_movemask_ps(mask.v) != 0;
+    }
+
+    inline Float4 exp2Int(Float4 whole)
+    {
+      __m128 clamped = _mm_min_ps(_mm_max_ps(whole.v, _mm_set1_ps(-126.f)), _mm_set1_ps(127.f));
+      __m128i exponent = _mm_add_epi32(_mm_cvttps_epi32(clamped), _mm_set1_epi32(127));
+      return _mm_castsi128_ps(_mm_slli_epi32(exponent, 23));
+    }
+
+    inline float sum(Float4 a)
+    {
+      __m128 pairs = _mm_add_ps(a.v, _mm_movehl_ps(a.v, a.v)); // 0+2, 1+3
+      return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+    }
+  }
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <stdint.h>
+#include <immintrin.h>
+
+namespace phnq
+{
+  namespace simd
+  {
+    /**
+     * @brief Eight float lanes in an AVX register (x86-64 hosts built with
+     * -mavx2).
+     */
+    struct Float8
+    {
+      __m256 v;
+
+      Float8() : v(_mm256_setzero_ps())
+      {
+      }
+
+      Float8(float value) : v(_mm256_set1_ps(value))
+      {
+      }
+
+      Float8(__m256 v) : v(v)
+      {
+      }
+
+      static Float8 load(const float *in)
+      {
+        return Float8(_mm256_loadu_ps(in));
+      }
+
+      void store(float *out) const
+      {
+        _mm256_storeu_ps(out, v);
+      }
+
+      float operator[](size_t lane) const
+      {
+        float lanes[8];
+        store(lanes);
+        return lanes[lane];
+      }
+
+      Float4 low() const
+      {
+        return _mm256_castps256_ps128(v);
+      }
+
+      Float4 high() const
+      {
+        return _mm256_extractf128_ps(v, 1);
+      }
+    };
+
+    inline Float8 operator+(Float8 a, Float8 b)
+    {
+      return _mm256_add_ps(a.v, b.v);
+    }
+
+    inline Float8 operator-(Float8 a, Float8 b)
+    {
+      return _mm256_sub_ps(a.v, b.v);
+    }
+
+    inline Float8 operator*(Float8 a, Float8 b)
+    {
+      return _mm256_mul_ps(a.v, b.v);
+    }
+
+    inline Float8 operator/(Float8 a, Float8 b)
+    {
+      return _mm256_div_ps(a.v, b.v);
+    }
+
+    inline Float8 operator-(Float8 a)
+    {
+      return _mm256_xor_ps(a.v, _mm256_set1_ps(-0.f));
+    }
+
+    inline Float8 operator<(Float8 a, Float8 b)
+    {
+      return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ);
+    }
+
+    inline Float8 operator<=(Float8 a, Float8 b)
+    {
+      return _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ);
+    }
+
+    inline Float8 operator>(Float8 a, Float8 b)
+    {
+      return _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ);
+    }
+
+    inline Float8 operator>=(Float8 a, Float8 b)
+    {
+      return _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ);
+    }
+
+    inline Float8 min(Float8 a, Float8 b)
+    {
+      return _mm256_min_ps(a.v, b.v);
+    }
+
+    inline Float8 max(Float8 a, Float8 b)
+    {
+      return _mm256_max_ps(a.v, b.v);
+    }
+
+    inline Float8 abs(Float8 a)
+    {
+      return _mm256_andnot_ps(_mm256_set1_ps(-0.f), a.v);
+    }
+
+    inline Float8 floor(Float8 a)
+    {
+      return _mm256_floor_ps(a.v);
+    }
+
+    inline Float8 sqrt(Float8 a)
+    {
+      return _mm256_sqrt_ps(a.v);
+    }
+
+    inline Float8 select(Float8 mask, Float8 a, Float8 b)
+    {
+      return _mm256_blendv_ps(b.v, a.v, mask.v);
+    }
+
+    inline Float8 operator&(Float8 a, Float8 b)
+    {
+      return _mm256_and_ps(a.v, b.v);
+    }
+
+    inline Float8 operator|(Float8 a, Float8 b)
+    {
+      return _mm256_or_ps(a.v, b.v);
+    }
+
+    inline Float8 andNot(Float8 mask, Float8 a)
+    {
+      return _mm256_andnot_ps(mask.v, a.v);
+    }
+
+    inline bool any(Float8 mask)
+    {
+      return _mm256_movemask_ps(mask.v) != 0;
+    }
+
+    inline Float8 exp2Int(Float8 whole)
+    {
+      __m256 clamped = _mm256_min_ps(_mm256_max_ps(whole.v, _mm256_set1_ps(-126.f)), _mm256_set1_ps(127.f));
+      __m256i exponent = _mm256_add_epi32(_mm256_cvttps_epi32(clamped), _mm256_set1_epi32(127));
+      return _mm256_castsi256_ps(_mm256_slli_epi32(exponent, 23));
+    }
+
+    inline float sum(Float8 a)
+    {
+      return sum(a.low() + a.high());
+    }
+  }
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+namespace phnq
+{
+  namespace simd
+  {
+    /**
+     * @brief Eight float lanes as two Float4s, where there's no 8-wide unit.
+     */
+    struct Float8
+    {
+      Float4 lo;
+      Float4 hi;
+
+      Float8()
+      {
+      }
+
+      Float8(float value) : lo(value), hi(value)
+      {
+      }
+
+      Float8(Float4 lo, Float4 hi) : lo(lo), hi(hi)
+      {
+      }
+
+      static Float8 load(const float *in)
+      {
+        return Float8(Float4::load(in), Float4::load(in + 4));
+      }
+
+      void store(float *out) const
+      {
+        lo.store(out);
+        hi.store(out + 4);
+      }
+
+      float operator[](size_t lane) const
+      {
+        return lane < 4 ? lo[lane] : hi[lane - 4];
+      }
+
+      Float4 low() const
+      {
+        return lo;
+      }
+
+      Float4 high() const
+      {
+        return hi;
+      }
+    };
+
+#define PHNQ_SIMD_PAIR_BINARY(op)                    \
+  inline Float8 op(Float8 a, Float8 b)               \
+  {                                                  \
+    return Float8(op(a.lo, b.lo), op(a.hi, b.hi));   \
+  }
+
+#define PHNQ_SIMD_PAIR_UNARY(op)                     \
+  inline Float8 op(Float8 a)                         \
+  {                                                  \
+    return Float8(op(a.lo), op(a.hi));               \
+  }
+
+    PHNQ_SIMD_PAIR_BINARY(operator+)
+    PHNQ_SIMD_PAIR_BINARY(operator-)
+    PHNQ_SIMD_PAIR_BINARY(operator*)
+    PHNQ_SIMD_PAIR_BINARY(operator/)
+    PHNQ_SIMD_PAIR_BINARY(operator<)
+    PHNQ_SIMD_PAIR_BINARY(operator<=)
+    PHNQ_SIMD_PAIR_BINARY(operator>)
+    PHNQ_SIMD_PAIR_BINARY(operator>=)
+    PHNQ_SIMD_PAIR_BINARY(operator&)
+    PHNQ_SIMD_PAIR_BINARY(operator|)
+    PHNQ_SIMD_PAIR_BINARY(andNot)
+    PHNQ_SIMD_PAIR_BINARY(min)
+    PHNQ_SIMD_PAIR_BINARY(max)
+    PHNQ_SIMD_PAIR_UNARY(operator-)
+    PHNQ_SIMD_PAIR_UNARY(abs)
+    PHNQ_SIMD_PAIR_UNARY(floor)
+    PHNQ_SIMD_PAIR_UNARY(sqrt)
+    PHNQ_SIMD_PAIR_UNARY(exp2Int)
+
+#undef PHNQ_SIMD_PAIR_BINARY
+#undef PHNQ_SIMD_PAIR_UNARY
+
+    inline Float8 select(Float8 mask, Float8 a, Float8 b)
+    {
+      return Float8(select(mask.lo, a.lo, b.lo), select(mask.hi, a.hi, b.hi));
+    }
+
+    inline bool any(Float8 mask)
+    {
+      return any(mask.lo) || any(mask.hi);
+    }
+
+    inline float sum(Float8 a)
+    {
+      return sum(a.lo + a.hi);
+    }
+  }
+}
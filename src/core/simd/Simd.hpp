@@ -0,0 +1,241 @@
+#pragma once
+
+/**
+ * phnq::simd
+ * ==========
+ * Float vector types, and block kernels over float arrays, for DSP code that is
+ * written once and built for every target:
+ *
+ * - `Float4` / `Float8`: 4 and 8 float lanes with arithmetic and comparison
+ *   operators, `min`/`max`/`abs`/`floor`/`sqrt`/`sum`, masks (`select`, `&`,
+ *   `|`, `andNot`, `any`), plus `clamp()` and `fastExp2()` built on those.
+ *   `NativeFloat` is the widest type the target runs in one instruction, with
+ *   `NATIVE_LANES` lanes.
+ *   - x86-64 (host, Rack on Linux/Windows/Intel Mac): SSE2, and AVX2 for
+ *     `Float8` when built with -mavx2.
+ *   - AArch64 (Rack on Apple silicon): NEON.
+ *   - Anything else, including the Seed's Cortex-M7, which has no float vector
+ *     unit: plain arrays of lanes, which the compiler schedules on the FPU.
+ * - Block kernels (`fill()`, `add()`, `scale()`, `mulAdd()`, ...): loops over
+ *   whole blocks, on `Float4` with a scalar remainder. Seed builds can define
+ *   `PHNQ_SIMD_CMSIS` to use CMSIS-DSP's Cortex-M7-tuned versions where one
+ *   exists; that path is not yet built by default, and its results needn't
+ *   match the other backends bit for bit.
+ *
+ * Every operation is lane-wise IEEE float arithmetic in a fixed order (`sum()`
+ * adds lanes 0+2 and 1+3, then the pairs), so results are bit-identical to the
+ * scalar backend, which can be forced with `PHNQ_SIMD_SCALAR` to check. That
+ * holds for non-NaN inputs, and as long as the compiler doesn't fuse
+ * multiply-adds. Clang, and GCC in GNU mode (as libDaisy builds the Seed), do
+ * by default wherever the target has FMA (AArch64, the Cortex-M7's FPU), so
+ * every build (Seed, Rack, host, bench) passes -ffp-contract=off.
+ * Comparisons return masks with all lane bits set or clear, only meant for the
+ * mask operations.
+ */
+
+#include <stddef.h>
+#include "../dsp/Exp2.hpp"
+
+#if defined(PHNQ_SIMD_SCALAR)
+#include "Float4Scalar.hpp"
+#elif defined(__SSE2__) || defined(_M_X64)
+#include "Float4Sse.hpp"
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include "Float4Neon.hpp"
+#else
+#include "Float4Scalar.hpp"
+#endif
+
+#if defined(__AVX2__) && !defined(PHNQ_SIMD_SCALAR)
+#include "Float8Avx.hpp"
+namespace phnq
+{
+  namespace simd
+  {
+    typedef Float8 NativeFloat;
+    const size_t NATIVE_LANES = 8;
+  }
+}
+#else
+#include "Float8Pair.hpp"
+namespace phnq
+{
+  namespace simd
+  {
+    typedef Float4 NativeFloat;
+    const size_t NATIVE_LANES = 4;
+  }
+}
+#endif
+
+#ifdef PHNQ_SIMD_CMSIS
+#include "arm_math.h"
+#endif
+
+namespace phnq
+{
+  namespace simd
+  {
+    inline Float4 &operator+=(Float4 &a, Float4 b)
+    {
+      return a = a + b;
+    }
+
+    inline Float4 &operator-=(Float4 &a, Float4 b)
+    {
+      return a = a - b;
+    }
+
+    inline Float4 &operator*=(Float4 &a, Float4 b)
+    {
+      return a = a * b;
+    }
+
+    inline Float8 &operator+=(Float8 &a, Float8 b)
+    {
+      return a = a + b;
+    }
+
+    inline Float8 &operator-=(Float8 &a, Float8 b)
+    {
+      return a = a - b;
+    }
+
+    inline Float8 &operator*=(Float8 &a, Float8 b)
+    {
+      return a = a * b;
+    }
+
+    template <class TVector>
+    inline TVector clamp(TVector x, TVector low, TVector high)
+    {
+      return min(max(x, low), high);
+    }
+
+    /**
+     * @brief `phnq::fastExp2()` on every lane, with the same result bits.
+     */
+    template <class TVector>
+    inline TVector fastExp2(TVector x)
+    {
+      TVector whole = floor(x + TVector(0.5f));
+      TVector fraction = x - whole;
+      TVector mantissa = TVector(1.f) + fraction * (TVector(EXP2_COEF_1) + fraction * (TVector(EXP2_COEF_2) + fraction * (TVector(EXP2_COEF_3) + fraction * TVector(EXP2_COEF_4))));
+      return mantissa * exp2Int(whole);
+    }
+
+    /*************************
+     ***** BLOCK KERNELS *****
+     *************************/
+
+    inline void fill(float *out, float value, size_t numFrames)
+    {
+#ifdef PHNQ_SIMD_CMSIS
+      arm_fill_f32(value, out, numFrames);
+#else
+      size_t frame = 0;
+      for (; frame + 4 <= numFrames; frame += 4)
+      {
+        Float4(value).store(&out[frame]);
+      }
+      for (; frame < numFrames; frame++)
+      {
+        out[frame] = value;
+      }
+#endif
+    }
+
+    /**
+     * @brief out = a + b
+     */
+    inline void add(const float *a, const float *b, float *out, size_t numFrames)
+    {
+#ifdef PHNQ_SIMD_CMSIS
+      arm_add_f32(const_cast<float *>(a), const_cast<float *>(b), out, numFrames);
+#else
+      size_t frame = 0;
+      for (; frame + 4 <= numFrames; frame += 4)
+      {
+        (Float4::load(&a[frame]) + Float4::load(&b[frame])).store(&out[frame]);
+      }
+      for (; frame < numFrames; frame++)
+      {
+        out[frame] = a[frame] + b[frame];
+      }
+#endif
+    }
+
+    /**
+     * @brief out = a * b
+     */
+    inline void multiply(const float *a, const float *b, float *out, size_t numFrames)
+    {
+#ifdef PHNQ_SIMD_CMSIS
+      arm_mult_f32(const_cast<float *>(a), const_cast<float *>(b), out, numFrames);
+#else
+      size_t frame = 0;
+      for (; frame + 4 <= numFrames; frame += 4)
+      {
+        (Float4::load(&a[frame]) * Float4::load(&b[frame])).store(&out[frame]);
+      }
+      for (; frame < numFrames; frame++)
+      {
+        out[frame] = a[frame] * b[frame];
+      }
+#endif
+    }
+
+    /**
+     * @brief out = in * gain
+     */
+    inline void scale(const float *in, float gain, float *out, size_t numFrames)
+    {
+#ifdef PHNQ_SIMD_CMSIS
+      arm_scale_f32(const_cast<float *>(in), gain, out, numFrames);
+#else
+      size_t frame = 0;
+      for (; frame + 4 <= numFrames; frame += 4)
+      {
+        (Float4::load(&in[frame]) * Float4(gain)).store(&out[frame]);
+      }
+      for (; frame < numFrames; frame++)
+      {
+        out[frame] = in[frame] * gain;
+      }
+#endif
+    }
+
+    /**
+     * @brief out += in * gain, i.e. mixing a scaled signal into a bus.
+     */
+    inline void mulAdd(const float *in, float gain, float *out, size_t numFrames)
+    {
+      size_t frame = 0;
+      for (; frame + 4 <= numFrames; frame += 4)
+      {
+        (Float4::load(&out[frame]) + Float4::load(&in[frame]) * Float4(gain)).store(&out[frame]);
+      }
+      for (; frame < numFrames; frame++)
+      {
+        out[frame] = out[frame] + in[frame] * gain;
+      }
+    }
+
+    /**
+     * @brief out = min(max(in, low), high)
+     */
+    inline void clamp(const float *in, float low, float high, float *out, size_t numFrames)
+    {
+      size_t frame = 0;
+      for (; frame + 4 <= numFrames; frame += 4)
+      {
+        clamp(Float4::load(&in[frame]), Float4(low), Float4(high)).store(&out[frame]);
+      }
+      for (; frame < numFrames; frame++)
+      {
+        float value = in[frame] > low ? in[frame] : low;
+        out[frame] = value < high ? value : high;
+      }
+    }
+  }
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <math.h>
+
+namespace phnq
+{
+  namespace engine
+  {
+    // Width of the noise band around a steady ADC reading, in the [0, 1] range of
+    // `AdcHandle::GetFloat()`: 4 LSBs of a 16-bit conversion, 0.2mV at 3V3.
+    const float ADC_DEADBAND = 4.f / 65536.f;
+
+    /**
+     * @brief Whether an ADC reading has moved far enough from the last one posted
+     * to the engine to be a real change rather than conversion noise. Always true
+     * while nothing has been posted yet (`postedValue` is NAN).
+     *
+     * A steady input jitters by a few LSBs from scan to scan, which is more than
+     * `CV_CHANGE_THRESHOLD` and would otherwise wake a sleeping engine on nearly
+     * every scan.
+     */
+    inline bool isAdcChange(float value, float postedValue)
+    {
+      return !(fabsf(value - postedValue) <= ADC_DEADBAND);
+    }
+  }
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include "ports/Port.hpp"
 #include "ports/AudioIn.hpp"
 #include "ports/AudioOut.hpp"
@@ -10,6 +11,10 @@
 #include "ports/Param.hpp"
 #include "ports/Button.hpp"
 #include "ports/Light.hpp"
+#include "PortView.hpp"
+#include "SpscQueue.hpp"
+#include "ParamSmoother.hpp"
+#include "../../core/dsp/Exp2.hpp"
 
 #ifdef PHNQ_RACK
 #include <rack.hpp>
@@ -43,9 +48,13 @@ namespace phnq
   {
     const float FREQ_C1 = 32.7032f;
 
-    static float pitchToFrequency(float pitch)
+    /**
+     * @brief Frequency for a pitch CV, 1/10 per octave above C1. Within 0.006
+     * cents of exact (see `fastExp2()`).
+     */
+    inline float pitchToFrequency(float pitch)
     {
-      return FREQ_C1 * std::pow(2.f, pitch * 10.f);
+      return FREQ_C1 * fastExp2(pitch * 10.f);
     }
 
     struct FrameInfo
@@ -54,10 +63,52 @@ namespace phnq
       float sampleTime;
     };
 
+    const size_t CONTROL_QUEUE_SIZE = 64;
+    const size_t DEFAULT_CONTROL_RATE_DIVIDER = 16;
+
+    // Audio below this level (about -80dB) counts as silence.
+    const float SILENCE_THRESHOLD = 0.0001f;
+    // How long output must stay silent before the engine goes to sleep.
+    const float SILENCE_SECONDS_BEFORE_SLEEP = 0.5f;
+
+    /**
+     * @brief How much of the time an engine has spent asleep.
+     */
+    struct SleepStats
+    {
+      uint64_t numFrames;       // Frames passed to the engine.
+      uint64_t numAsleepFrames; // Frames skipped while asleep.
+      uint32_t numSleeps;       // Times the engine went to sleep.
+    };
+
+    /**
+     * @brief An input value change posted from outside the audio thread. Exactly
+     * one of `cvIn` (CV ins, params and buttons) or `gateIn` is set.
+     */
+    struct ControlEvent
+    {
+      CVIn *cvIn;
+      GateIn *gateIn;
+      float value;
+    };
+
     struct Engine
     {
     private:
-      FrameInfo frameInfo;
+      SpscQueue<ControlEvent, CONTROL_QUEUE_SIZE> controlQueue;
+      ParamSmoother smoother;
+      bool isSmootherSetUp = false;
+      size_t controlRateDivider = DEFAULT_CONTROL_RATE_DIVIDER;
+      size_t framesUntilControl = 0;
+      FrameInfo frameInfo = {0.f, 0.f};
+
+      bool isAsleep = false;
+      bool areOutputsConnected = true;
+      uint64_t numSilentFrames = 0;
+      uint64_t silentFramesBeforeSleep = 0;
+      uint32_t asleepInputGeneration = 0;
+      SleepStats sleepStats = {0, 0, 0};
+
       std::vector<AudioIn *> audioIns;
       std::vector<AudioOut *> audioOuts;
       std::vector<CVIn *> cvIns;
@@ -72,54 +123,413 @@ namespace phnq
       {
       }
 
-      const std::vector<AudioIn *> getAudioIns()
+      virtual ~Engine()
+      {
+      }
+
+      PortView<AudioIn> getAudioIns()
+      {
+        return PortView<AudioIn>(this->audioIns.data(), this->audioIns.size());
+      }
+
+      PortView<AudioOut> getAudioOuts()
+      {
+        return PortView<AudioOut>(this->audioOuts.data(), this->audioOuts.size());
+      }
+
+      PortView<CVIn> getCVIns()
+      {
+        return PortView<CVIn>(this->cvIns.data(), this->cvIns.size());
+      }
+
+      PortView<CVOut> getCVOuts()
+      {
+        return PortView<CVOut>(this->cvOuts.data(), this->cvOuts.size());
+      }
+
+      PortView<GateIn> getGateIns()
       {
-        return this->audioIns;
+        return PortView<GateIn>(this->gateIns.data(), this->gateIns.size());
       }
 
-      const std::vector<AudioOut *> getAudioOuts()
+      PortView<GateOut> getGateOuts()
       {
-        return this->audioOuts;
+        return PortView<GateOut>(this->gateOuts.data(), this->gateOuts.size());
       }
 
-      const std::vector<CVIn *> getCVIns()
+      PortView<Param> getParams()
       {
-        return this->cvIns;
+        return PortView<Param>(this->params.data(), this->params.size());
       }
 
-      const std::vector<CVOut *> getCVOuts()
+      PortView<Light> getLights()
       {
-        return this->cvOuts;
+        return PortView<Light>(this->lights.data(), this->lights.size());
       }
 
-      const std::vector<GateIn *> getGateIns()
+      /**
+       * @brief Queue a value change for an input port from a thread other than the
+       * one processing audio (i.e. the Seed's scan loop). Queued changes are
+       * scheduled at the first frame of the next `doProcess()`/`doProcessBlock()`
+       * on the audio thread, where listeners are called. Wait-free.
+       *
+       * @return false if the queue is full and the change was dropped.
+       */
+      bool postValue(CVIn *cvIn, float value)
       {
-        return this->gateIns;
+        return controlQueue.push({cvIn, NULL, value});
       }
 
-      const std::vector<GateOut *> getGateOuts()
+      bool postValue(GateIn *gateIn, bool value)
       {
-        return this->gateOuts;
+        return controlQueue.push({NULL, gateIn, value ? 1.f : 0.f});
       }
 
-      const std::vector<Param *> getParams()
+      /**
+       * @brief Tell the engine whether anything is listening to its outputs (i.e.
+       * whether any Rack output has a cable). With nothing connected the engine
+       * sleeps.
+       */
+      void setOutputsConnected(bool connected)
       {
-        return this->params;
+        this->areOutputsConnected = connected;
       }
 
-      const std::vector<Light *> getLights()
+      SleepStats getSleepStats()
       {
-        return this->lights;
+        return this->sleepStats;
+      }
+
+      /**
+       * @brief Whether the engine skipped its last frame or block, or went to sleep
+       * at the end of it.
+       */
+      bool isSleeping()
+      {
+        return this->isAsleep;
       }
 
       void doProcess(FrameInfo frameInfo)
+      {
+        applyControlEvents();
+
+        updateFrameInfo(frameInfo);
+
+        sleepStats.numFrames++;
+        if (isAsleep && !wakeIfNeeded(1, NULL))
+        {
+          applyInputEvents(0, 1);
+          advanceInputEvents(1);
+          for (AudioOut *audioOut : audioOuts)
+          {
+            audioOut->setValue(0.f);
+            audioOut->clearChannelValues();
+          }
+          sleepStats.numAsleepFrames++;
+          return;
+        }
+
+        applyInputEvents(0, 1);
+        smoother.process(1);
+        if (framesUntilControl == 0)
+        {
+          framesUntilControl = controlRateDivider;
+          this->processControl(frameInfo);
+        }
+        framesUntilControl--;
+        this->process(frameInfo);
+        advanceInputEvents(1);
+
+        bool isSilent = true;
+        for (AudioOut *audioOut : audioOuts)
+        {
+          isSilent &= fabsf(audioOut->getValue()) <= SILENCE_THRESHOLD;
+        }
+        sleepIfIdle(1, isSilent);
+      }
+
+      /**
+       * @brief Process a block of `numFrames` sample frames. The buffers are indexed
+       * in the same order as `getAudioIns()` and `getAudioOuts()`, and each holds
+       * `numFrames` samples.
+       *
+       * Value changes scheduled on input ports (see `InputPort::scheduleValue()`) are
+       * applied at their exact frame, and `processControl()` runs every control
+       * period: the block is split at those frames, so `processBlock()` may be called
+       * several times with shorter blocks, with listeners and `processControl()`
+       * called between the sub-blocks.
+       *
+       * The engine goes to sleep when nothing is connected to its outputs, when
+       * `isIdle()` says so, or when an engine with only audio outputs has been
+       * silent for `SILENCE_SECONDS_BEFORE_SLEEP`. While asleep, input changes are
+       * still applied (and listeners called), but no processing is done and
+       * audio outputs are zero, until an input changes or audio input arrives.
+       *
+       * @param frameInfo sample rate info.
+       * @param numFrames number of frames in the block.
+       * @param audioInBlocks one input buffer per AudioIn port.
+       * @param audioOutBlocks one output buffer per AudioOut port.
+       */
+      void doProcessBlock(FrameInfo frameInfo, size_t numFrames, const float *const *audioInBlocks, float *const *audioOutBlocks)
+      {
+        applyControlEvents();
+
+        updateFrameInfo(frameInfo);
+
+        sleepStats.numFrames += numFrames;
+        if (isAsleep && !wakeIfNeeded(numFrames, audioInBlocks))
+        {
+          if (numFrames > 0)
+          {
+            applyInputEvents(numFrames - 1, numFrames);
+            advanceInputEvents(numFrames);
+          }
+          for (size_t i = 0; i < audioOuts.size(); i++)
+          {
+            std::fill(audioOutBlocks[i], audioOutBlocks[i] + numFrames, 0.f);
+          }
+          sleepStats.numAsleepFrames += numFrames;
+          return;
+        }
+
+        size_t frame = 0;
+        while (frame < numFrames)
+        {
+          size_t nextFrame = applyInputEvents(frame, numFrames);
+
+          bool isControlFrame = framesUntilControl == 0;
+          if (isControlFrame)
+          {
+            framesUntilControl = controlRateDivider;
+          }
+          nextFrame = std::min(nextFrame, frame + framesUntilControl);
+          framesUntilControl -= nextFrame - frame;
+
+          smoother.process(nextFrame - frame);
+          if (isControlFrame)
+          {
+            this->processControl(frameInfo);
+          }
+
+          for (size_t i = 0; i < audioIns.size(); i++)
+          {
+            audioIns[i]->setBlock(audioInBlocks[i] + frame);
+          }
+          for (size_t i = 0; i < audioOuts.size(); i++)
+          {
+            audioOuts[i]->setBlock(audioOutBlocks[i] + frame);
+          }
+
+          this->processBlock(frameInfo, nextFrame - frame);
+          frame = nextFrame;
+        }
+
+        advanceInputEvents(numFrames);
+
+        bool isSilent = true;
+        for (size_t i = 0; i < audioOuts.size(); i++)
+        {
+          isSilent &= isBlockSilent(audioOutBlocks[i], numFrames);
+        }
+        sleepIfIdle(numFrames, isSilent);
+      }
+
+    private:
+      static bool isBlockSilent(const float *block, size_t numFrames)
+      {
+        float peak = 0.f;
+        for (size_t frame = 0; frame < numFrames; frame++)
+        {
+          peak = std::max(peak, fabsf(block[frame]));
+        }
+        return peak <= SILENCE_THRESHOLD;
+      }
+
+      /**
+       * @brief Sum of all input port generations, which changes whenever any input
+       * value does.
+       */
+      uint32_t getInputGeneration()
+      {
+        uint32_t generation = 0;
+        for (CVIn *cvIn : cvIns)
+        {
+          generation += cvIn->getGeneration();
+        }
+        for (GateIn *gateIn : gateIns)
+        {
+          generation += gateIn->getGeneration();
+        }
+        for (Param *param : params)
+        {
+          generation += param->getGeneration();
+        }
+        return generation;
+      }
+
+      bool hasInputEvents(size_t numFrames)
+      {
+        size_t nextFrame = numFrames;
+        findNextEventFrame(cvIns, nextFrame);
+        findNextEventFrame(gateIns, nextFrame);
+        findNextEventFrame(params, nextFrame);
+        return nextFrame < numFrames;
+      }
+
+      /**
+       * @brief Go to sleep after a processed block if there is nothing to do.
+       */
+      void sleepIfIdle(size_t numFrames, bool isSilent)
+      {
+        numSilentFrames = this->canSleepWhenSilent() && isSilent ? numSilentFrames + numFrames : 0;
+
+        if (!areOutputsConnected || this->isIdle() || numSilentFrames >= silentFramesBeforeSleep)
+        {
+          isAsleep = true;
+          asleepInputGeneration = getInputGeneration();
+          sleepStats.numSleeps++;
+        }
+      }
+
+      /**
+       * @brief Wake up if an input changed or is due to change in the next
+       * `numFrames` frames, or audio is coming in. Engines stay asleep while their
+       * outputs are disconnected.
+       *
+       * @param audioInBlocks the next block's audio input, or NULL to use the AudioIn
+       * port values.
+       * @return true if the engine woke up.
+       */
+      bool wakeIfNeeded(size_t numFrames, const float *const *audioInBlocks)
+      {
+        if (!areOutputsConnected)
+        {
+          return false;
+        }
+
+        bool hasInput = getInputGeneration() != asleepInputGeneration || hasInputEvents(numFrames);
+        for (size_t i = 0; i < audioIns.size() && !hasInput; i++)
+        {
+          hasInput = audioInBlocks ? !isBlockSilent(audioInBlocks[i], numFrames) : fabsf(audioIns[i]->getValue()) > SILENCE_THRESHOLD;
+        }
+
+        if (hasInput)
+        {
+          isAsleep = false;
+          numSilentFrames = 0;
+          framesUntilControl = 0;
+        }
+        return hasInput;
+      }
+
+      void updateFrameInfo(FrameInfo frameInfo)
       {
         if (frameInfo.sampleRate != this->frameInfo.sampleRate)
         {
           this->frameInfo = frameInfo;
+          silentFramesBeforeSleep = (uint64_t)(SILENCE_SECONDS_BEFORE_SLEEP * frameInfo.sampleRate);
+
+          // Ports opt in to smoothing when they are created, so by the first
+          // processed frame they are all known.
+          if (!isSmootherSetUp)
+          {
+            for (CVIn *cvIn : cvIns)
+            {
+              addSmoothedPort(cvIn);
+            }
+            for (Param *param : params)
+            {
+              addSmoothedPort(param);
+            }
+            isSmootherSetUp = true;
+          }
+          smoother.setSampleRate(frameInfo.sampleRate);
+
           sampleRateDidChange(frameInfo.sampleRate);
         }
-        this->process(frameInfo);
+      }
+
+      void addSmoothedPort(CVIn *port)
+      {
+        if (port->getSmoothingTime() > 0.f && !smoother.add(port))
+        {
+          PHNQ_LOG("Too many smoothed ports, not smoothing: %s", port->getId().c_str());
+        }
+      }
+
+      void applyControlEvents()
+      {
+        ControlEvent event;
+        while (controlQueue.pop(event))
+        {
+          if (event.gateIn)
+          {
+            event.gateIn->scheduleValue(event.value > 0.5f, 0);
+          }
+          else
+          {
+            event.cvIn->scheduleValue(event.value, 0);
+          }
+        }
+      }
+
+      /**
+       * @brief Apply input changes scheduled at or before `frame`.
+       *
+       * @return the frame of the next scheduled change, or `numFrames` if there is
+       * none in this block.
+       */
+      size_t applyInputEvents(size_t frame, size_t numFrames)
+      {
+        size_t nextFrame = numFrames;
+        applyPortEvents(cvIns, frame, nextFrame);
+        applyPortEvents(gateIns, frame, nextFrame);
+        applyPortEvents(params, frame, nextFrame);
+        return nextFrame;
+      }
+
+      void advanceInputEvents(size_t numFrames)
+      {
+        advancePortEvents(cvIns, numFrames);
+        advancePortEvents(gateIns, numFrames);
+        advancePortEvents(params, numFrames);
+      }
+
+      template <class TPort>
+      static void applyPortEvents(std::vector<TPort *> &ports, size_t frame, size_t &nextFrame)
+      {
+        for (TPort *port : ports)
+        {
+          if (port->hasEvents())
+          {
+            port->applyEvents(frame);
+            if (port->hasEvents() && port->getNextEventFrame() < nextFrame)
+            {
+              nextFrame = port->getNextEventFrame();
+            }
+          }
+        }
+      }
+
+      template <class TPort>
+      static void findNextEventFrame(std::vector<TPort *> &ports, size_t &nextFrame)
+      {
+        for (TPort *port : ports)
+        {
+          if (port->hasEvents() && port->getNextEventFrame() < nextFrame)
+          {
+            nextFrame = port->getNextEventFrame();
+          }
+        }
+      }
+
+      template <class TPort>
+      static void advancePortEvents(std::vector<TPort *> &ports, size_t numFrames)
+      {
+        for (TPort *port : ports)
+        {
+          port->advanceEvents(numFrames);
+        }
       }
 
     protected:
@@ -127,63 +537,103 @@ namespace phnq
 
       AudioIn *createAudioIn(std::string id)
       {
-        AudioIn *audioIn = new AudioIn();
+        return addPort(new AudioIn(), id);
+      }
+
+      AudioOut *createAudioOut(std::string id)
+      {
+        return addPort(new AudioOut(), id);
+      }
+
+      CVIn *createCVIn(std::string id)
+      {
+        return addPort(new CVIn(), id);
+      }
+
+      CVOut *createCVOut(std::string id)
+      {
+        return addPort(new CVOut(), id);
+      }
+
+      GateIn *createGateIn(std::string id)
+      {
+        return addPort(new GateIn(), id);
+      }
+
+      GateOut *createGateOut(std::string id)
+      {
+        return addPort(new GateOut(), id);
+      }
+
+      Param *createParam(std::string id)
+      {
+        return addPort(new Param(), id);
+      }
+
+      Button *createButton(std::string id)
+      {
+        return addPort(new Button(), id);
+      }
+
+      Light *createLight(std::string id)
+      {
+        return addPort(new Light(), id);
+      }
+
+      /**
+       * @brief Register a port whose storage is owned elsewhere (i.e. by a
+       * StaticEngine). Ports are listed in registration order.
+       */
+      AudioIn *addPort(AudioIn *audioIn, std::string id)
+      {
         this->audioIns.push_back(audioIn);
         return static_cast<AudioIn *>(audioIn->setId(id));
       }
 
-      AudioOut *createAudioOut(std::string id)
+      AudioOut *addPort(AudioOut *audioOut, std::string id)
       {
-        AudioOut *audioOut = new AudioOut();
         this->audioOuts.push_back(audioOut);
         return static_cast<AudioOut *>(audioOut->setId(id));
       }
 
-      CVIn *createCVIn(std::string id)
+      CVIn *addPort(CVIn *cvIn, std::string id)
       {
-        CVIn *cvIn = new CVIn();
         this->cvIns.push_back(cvIn);
         return static_cast<CVIn *>(cvIn->setId(id));
       }
 
-      CVOut *createCVOut(std::string id)
+      CVOut *addPort(CVOut *cvOut, std::string id)
       {
-        CVOut *cvOut = new CVOut();
         this->cvOuts.push_back(cvOut);
         return static_cast<CVOut *>(cvOut->setId(id));
       }
 
-      GateIn *createGateIn(std::string id)
+      GateIn *addPort(GateIn *gateIn, std::string id)
       {
-        GateIn *gateIn = new GateIn();
         this->gateIns.push_back(gateIn);
         return static_cast<GateIn *>(gateIn->setId(id));
       }
 
-      GateOut *createGateOut(std::string id)
+      GateOut *addPort(GateOut *gateOut, std::string id)
       {
-        GateOut *gateOut = new GateOut();
         this->gateOuts.push_back(gateOut);
         return static_cast<GateOut *>(gateOut->setId(id));
       }
 
-      Param *createParam(std::string id)
+      Param *addPort(Param *param, std::string id)
       {
-        Param *param = new Param();
         this->params.push_back(param);
         return static_cast<Param *>(param->setId(id));
       }
 
-      Button *createButton(std::string id)
+      Button *addPort(Button *button, std::string id)
       {
-        Button *button = new Button();
         this->params.push_back(button);
         return static_cast<Button *>(button->setId(id));
       }
 
-      Light *createLight(std::string id)
+      Light *addPort(Light *light, std::string id)
       {
-        Light *light = new Light();
         this->lights.push_back(light);
         return static_cast<Light *>(light->setId(id));
       }
@@ -193,9 +643,80 @@ namespace phnq
         return this->frameInfo;
       }
 
+      /**
+       * @brief Set how many frames pass between calls to `processControl()`. Call
+       * from the constructor.
+       *
+       * @param divider control period in frames, at least 1.
+       */
+      void setControlRateDivider(size_t divider)
+      {
+        this->controlRateDivider = std::max<size_t>(divider, 1);
+        this->framesUntilControl = 0;
+      }
+
+      size_t getControlRateDivider()
+      {
+        return this->controlRateDivider;
+      }
+
+      /**
+       * @brief Override for slow-changing work such as reading knobs and updating
+       * coefficients. Called every `getControlRateDivider()` frames, before the
+       * `process()`/`processBlock()` call covering that frame, so audio-rate
+       * processing only does per-sample DSP.
+       */
+      virtual void processControl(FrameInfo frameInfo)
+      {
+      }
+
+      /**
+       * @brief Override to report that the engine has nothing to do (i.e. no voices),
+       * so it can sleep right away instead of waiting for its output to go silent.
+       * Checked after each processed block.
+       */
+      virtual bool isIdle()
+      {
+        return false;
+      }
+
+      /**
+       * @brief Whether `SILENCE_SECONDS_BEFORE_SLEEP` of silent audio output means
+       * there is nothing to do. By default only for engines without CV or gate
+       * outs, since those outputs can't be judged by level. Override to return
+       * false for engines that can go quiet while still busy inside.
+       */
+      virtual bool canSleepWhenSilent()
+      {
+        return !audioOuts.empty() && cvOuts.empty() && gateOuts.empty();
+      }
+
       virtual void process(FrameInfo frameInfo)
       {
       }
+
+      /**
+       * @brief Override to compute a whole block at once, reading `AudioIn::getBlock()`
+       * and writing `AudioOut::getBlock()`. The default implementation adapts the block
+       * to the per-sample `process()`.
+       */
+      virtual void processBlock(FrameInfo frameInfo, size_t numFrames)
+      {
+        for (size_t frame = 0; frame < numFrames; frame++)
+        {
+          for (AudioIn *audioIn : audioIns)
+          {
+            audioIn->setValue(audioIn->getBlock()[frame]);
+          }
+
+          this->process(frameInfo);
+
+          for (AudioOut *audioOut : audioOuts)
+          {
+            audioOut->getBlock()[frame] = audioOut->getValue();
+          }
+        }
+      }
     };
   }
 }
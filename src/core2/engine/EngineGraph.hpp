@@ -0,0 +1,903 @@
+#pragma once
+
+#include <assert.h>
+#include <stdint.h>
+#include "StaticEngine.hpp"
+#include "Oversampler.hpp"
+
+namespace phnq
+{
+  namespace engine
+  {
+    // Longest block passed to the nodes; longer blocks are split.
+    const size_t GRAPH_MAX_BLOCK_SIZE = 256;
+
+    /**
+     * @brief A connection between two ports. For links from an output, the graph
+     * passes the value on whenever the output's generation changes.
+     */
+    template <class TFrom, class TTo>
+    struct PortLink
+    {
+      TFrom *from;
+      TTo *to;
+      uint32_t sentGeneration; // Generation of `from` last passed on.
+    };
+
+    /**
+     * @brief Where one of a node's audio ports reads or writes its block: the
+     * graph's own input or output block, or an intermediate buffer. `source` is
+     * the port whose value feeds an input when processing per sample.
+     */
+    struct GraphBlock
+    {
+      AudioIn *graphIn;
+      AudioOut *graphOut;
+      float *buffer;
+      Port<float> *source; // NULL for silence.
+
+      /**
+       * @brief The block for the frames starting at `frame` of the graph's current
+       * block. Intermediate buffers only ever hold one chunk, so they ignore `frame`.
+       */
+      const float *getInBlock(size_t frame)
+      {
+        return graphIn ? graphIn->getBlock() + frame : getOutBlock(frame);
+      }
+
+      float *getOutBlock(size_t frame)
+      {
+        return graphOut ? graphOut->getBlock() + frame : buffer;
+      }
+    };
+
+    /**
+     * @brief An engine inside an EngineGraph, with its audio blocks resolved and
+     * the links from its CV and gate outputs to other nodes. Oversampled nodes
+     * also have per-port converters and blocks at their own rate.
+     */
+    struct GraphNode
+    {
+      Engine *engine;
+      std::vector<GraphBlock> audioIns;  // One per AudioIn, in port order.
+      std::vector<GraphBlock> audioOuts; // One per AudioOut, in port order.
+      std::vector<const float *> audioInBlocks;
+      std::vector<float *> audioOutBlocks;
+      std::vector<PortLink<CVOut, CVIn>> cvLinks;
+      std::vector<PortLink<GateOut, GateIn>> gateLinks;
+
+      size_t oversampling;
+      std::vector<Oversampler> upsamplers;   // One per AudioIn.
+      std::vector<Oversampler> downsamplers; // One per AudioOut.
+      std::vector<std::vector<float>> oversampledIns;
+      std::vector<std::vector<float>> oversampledOuts;
+      std::vector<const float *> oversampledInBlocks;
+      std::vector<float *> oversampledOutBlocks;
+      std::vector<float> frameIns; // Per-sample processing: one frame per port.
+      std::vector<float> frameOuts;
+    };
+
+    /**
+     * @brief Called by a NodeScheduler to process one node of the current chunk.
+     */
+    struct NodeRunner
+    {
+      virtual void runNode(size_t index) = 0;
+    };
+
+    /**
+     * @brief Decides how an EngineGraph's nodes run when processing blocks. Without
+     * one, nodes run one after another in topological order; hosts with several
+     * cores can install one that runs independent nodes concurrently (see
+     * `core2/host/WorkStealingScheduler.hpp`).
+     */
+    struct NodeScheduler
+    {
+      virtual ~NodeScheduler()
+      {
+      }
+
+      /**
+       * @brief Called at setup, and again whenever the graph changes.
+       *
+       * @param dependents for each node, the nodes connected from it, which must
+       * not start before it has finished.
+       */
+      virtual void setDependencies(const std::vector<std::vector<size_t>> &dependents) = 0;
+
+      /**
+       * @brief Call `runner.runNode()` once for every node, never before the nodes it
+       * depends on have finished, and return once all have.
+       */
+      virtual void runNodes(NodeRunner &runner) = 0;
+    };
+
+    /**
+     * @brief The part of EngineGraph that hosts can reach without knowing its
+     * schema, i.e. through `dynamic_cast` from an `Engine *`.
+     */
+    struct SchedulableGraph
+    {
+      virtual ~SchedulableGraph()
+      {
+      }
+
+      /**
+       * @brief Run nodes through `scheduler` (not owned), or in order if NULL. Call
+       * at setup, not while processing.
+       */
+      virtual void setScheduler(NodeScheduler *scheduler) = 0;
+    };
+
+    /**
+     * @brief An engine made of other engines (nodes), such as a voice feeding an
+     * effect, so several can run on one Seed or in one Rack module. Nodes are
+     * added with `addNode()`, which hands over ownership, and wired with
+     * `connect()` in the subclass's constructor. Signal flows from the first
+     * argument to the second:
+     * - the graph's own input ports (declared by `TSchema` and created as usual)
+     *   to node inputs,
+     * - node outputs to node inputs,
+     * - node outputs to the graph's own output ports (one source each).
+     *
+     * Nodes are processed in topological order, which is recomputed as nodes and
+     * connections are added. When processing blocks, each node works directly in
+     * the graph's input/output blocks or in intermediate buffers, which are
+     * allocated while connecting and shared by connections whose lifetimes don't
+     * overlap, so nothing is copied or allocated on the audio thread. Unconnected
+     * node inputs read silence.
+     *
+     * CV and gate values move between nodes as scheduled values at the start of
+     * each block (or frame), since that's when the producing node has finished.
+     * The graph listens to its own input ports to pass their changes on at the
+     * exact frame, so those ports must not be given other listeners. Polyphonic
+     * channels only pass through audio ports connected to the graph's own ports,
+     * per sample.
+     *
+     * A node can be oversampled by 2, 4 or 8 (see `addNode()`): it then runs at
+     * that multiple of the graph's rate, with its audio converted up and down by
+     * half-band filters around it, while the rest of the graph and all control
+     * ports stay at the graph's rate. Polyphonic channels don't pass through
+     * oversampled nodes, and their audio lags their CV and gates by the
+     * converters' latency (`Oversampler::getLatency()`).
+     *
+     * The graph goes to sleep only once all its nodes are asleep, not when its
+     * output is silent, since nodes may still be at work on each other's CV and
+     * gates (e.g. a clock between the notes it gates).
+     *
+     * With a NodeScheduler set, blocks are processed by running nodes through it,
+     * possibly on several threads. Intermediate buffers are then no longer
+     * shared, since nodes that aren't connected may run at the same time, and
+     * each node input may only have one CV or gate source.
+     */
+    template <class TSchema>
+    struct EngineGraph : StaticEngine<TSchema>, SchedulableGraph, CVIn::CVInChangeListener, GateIn::GateChangeListener, Button::ButtonChangeListener, private NodeRunner
+    {
+    private:
+      std::vector<GraphNode> nodes;                // In processing order.
+      std::vector<std::vector<size_t>> dependents; // Per node, the nodes connected from it.
+      NodeScheduler *scheduler = NULL;
+
+      // The chunk being processed, for `runNode()`.
+      FrameInfo chunkFrameInfo = {0.f, 0.f};
+      size_t chunkFrame = 0;
+      size_t numChunkFrames = 0;
+
+      std::vector<PortLink<AudioOut, AudioIn>> audioLinks;
+      std::vector<PortLink<AudioIn, AudioIn>> audioInLinks;
+      std::vector<PortLink<AudioOut, AudioOut>> audioOutLinks;
+      std::vector<PortLink<CVIn, CVIn>> cvInLinks;
+      std::vector<PortLink<CVOut, CVOut>> cvOutLinks;
+      std::vector<PortLink<GateIn, GateIn>> gateInLinks;
+      std::vector<PortLink<GateOut, GateOut>> gateOutLinks;
+      std::vector<AudioOut *> unlinkedAudioOuts; // Graph outputs with no source.
+
+      // Intermediate buffers: silence, then scratch for unconnected node outputs,
+      // then one per concurrently live connection.
+      std::vector<std::vector<float>> buffers;
+
+    public:
+      EngineGraph()
+      {
+        // The graph itself has no control-rate work, so blocks are only split at
+        // input changes.
+        this->setControlRateDivider(GRAPH_MAX_BLOCK_SIZE);
+      }
+
+      ~EngineGraph()
+      {
+        for (GraphNode &node : nodes)
+        {
+          delete node.engine;
+        }
+      }
+
+      void setScheduler(NodeScheduler *scheduler) override
+      {
+        this->scheduler = scheduler;
+        if (scheduler)
+        {
+          scheduler->setDependencies(dependents);
+        }
+        assignBlocks();
+      }
+
+      void cvInValueDidChange(CVIn *port, float value) override
+      {
+        for (PortLink<CVIn, CVIn> &link : cvInLinks)
+        {
+          if (link.from == port)
+          {
+            link.to->scheduleValue(value, 0);
+          }
+        }
+      }
+
+      void buttonValueDidChange(Button *port, bool value) override
+      {
+        cvInValueDidChange(port, port->getValue());
+      }
+
+      void gateValueDidChange(GateIn *port, bool value) override
+      {
+        for (PortLink<GateIn, GateIn> &link : gateInLinks)
+        {
+          if (link.from == port)
+          {
+            link.to->scheduleValue(value, 0);
+          }
+        }
+      }
+
+    protected:
+      /**
+       * @brief Add an engine to the graph, which deletes it when deleted.
+       *
+       * @param oversampling 1, or 2, 4 or 8 to run the engine at that multiple of
+       * the graph's sample rate. Engine frame counts (control rate divider,
+       * port delays) are then in oversampled frames. Its audio outputs then lag by
+       * 11 to 13.25 graph frames, plus 12 to 15 for audio coming in, which is not
+       * compensated.
+       * @return TEngine* the node, for connecting its ports.
+       */
+      template <class TEngine>
+      TEngine *addNode(TEngine *engine, size_t oversampling = 1)
+      {
+        GraphNode node;
+        node.engine = engine;
+        node.oversampling = oversampling;
+        size_t numIns = engine->getAudioIns().size();
+        size_t numOuts = engine->getAudioOuts().size();
+        if (oversampling > 1)
+        {
+          node.upsamplers.resize(numIns);
+          node.downsamplers.resize(numOuts);
+          for (Oversampler &upsampler : node.upsamplers)
+          {
+            upsampler.init(oversampling, GRAPH_MAX_BLOCK_SIZE, false);
+          }
+          for (Oversampler &downsampler : node.downsamplers)
+          {
+            downsampler.init(oversampling, GRAPH_MAX_BLOCK_SIZE, true);
+          }
+          node.oversampledIns.assign(numIns, std::vector<float>(GRAPH_MAX_BLOCK_SIZE * oversampling, 0.f));
+          node.oversampledOuts.assign(numOuts, std::vector<float>(GRAPH_MAX_BLOCK_SIZE * oversampling, 0.f));
+          node.oversampledInBlocks.assign(numIns, NULL);
+          node.oversampledOutBlocks.assign(numOuts, NULL);
+          node.frameIns.assign(numIns, 0.f);
+          node.frameOuts.assign(numOuts, 0.f);
+        }
+        nodes.push_back(node);
+        sortNodes();
+        return engine;
+      }
+
+      void connect(AudioIn *graphIn, AudioIn *nodeIn)
+      {
+        assert(hasPort(this, graphIn) && !findAudioSource(nodeIn));
+        audioInLinks.push_back({graphIn, nodeIn, UINT32_MAX});
+        assignBlocks();
+      }
+
+      void connect(AudioOut *nodeOut, AudioIn *nodeIn)
+      {
+        assert(!findAudioSource(nodeIn));
+        findNode(nodeOut);
+        findNode(nodeIn);
+        audioLinks.push_back({nodeOut, nodeIn, UINT32_MAX});
+        sortNodes();
+      }
+
+      void connect(AudioOut *nodeOut, AudioOut *graphOut)
+      {
+        for (PortLink<AudioOut, AudioOut> &link : audioOutLinks)
+        {
+          assert(link.from != nodeOut && link.to != graphOut && "Audio outputs can only be connected to one graph output");
+        }
+        assert(hasPort(this, graphOut));
+        assert(!(graphOut->isPolyphonic() && findNode(nodeOut).oversampling > 1) && "Polyphonic channels don't pass through oversampled nodes");
+        findNode(nodeOut);
+        audioOutLinks.push_back({nodeOut, graphOut, UINT32_MAX});
+        assignBlocks();
+      }
+
+      void connect(CVIn *graphIn, CVIn *nodeIn)
+      {
+        assert(hasPort(this, graphIn) && !hasSource(nodeIn));
+        findNode(nodeIn);
+        graphIn->setListener(this);
+        cvInLinks.push_back({graphIn, nodeIn, UINT32_MAX});
+      }
+
+      void connect(Button *graphIn, Param *nodeIn)
+      {
+        assert(hasPort(this, graphIn) && !hasSource(nodeIn));
+        findNode(nodeIn);
+        graphIn->setListener(static_cast<Button::ButtonChangeListener *>(this));
+        cvInLinks.push_back({graphIn, nodeIn, UINT32_MAX});
+      }
+
+      void connect(CVOut *nodeOut, CVIn *nodeIn)
+      {
+        assert(!hasSource(nodeIn));
+        findNode(nodeIn);
+        findNode(nodeOut).cvLinks.push_back({nodeOut, nodeIn, UINT32_MAX});
+        sortNodes();
+      }
+
+      void connect(CVOut *nodeOut, CVOut *graphOut)
+      {
+        assert(hasPort(this, graphOut));
+        findNode(nodeOut);
+        cvOutLinks.push_back({nodeOut, graphOut, UINT32_MAX});
+      }
+
+      void connect(GateIn *graphIn, GateIn *nodeIn)
+      {
+        assert(hasPort(this, graphIn) && !hasSource(nodeIn));
+        findNode(nodeIn);
+        graphIn->setListener(this);
+        gateInLinks.push_back({graphIn, nodeIn, UINT32_MAX});
+      }
+
+      void connect(GateOut *nodeOut, GateIn *nodeIn)
+      {
+        assert(!hasSource(nodeIn));
+        findNode(nodeIn);
+        findNode(nodeOut).gateLinks.push_back({nodeOut, nodeIn, UINT32_MAX});
+        sortNodes();
+      }
+
+      void connect(GateOut *nodeOut, GateOut *graphOut)
+      {
+        assert(hasPort(this, graphOut));
+        findNode(nodeOut);
+        gateOutLinks.push_back({nodeOut, graphOut, UINT32_MAX});
+      }
+
+      void process(FrameInfo frameInfo) override
+      {
+        for (PortLink<AudioIn, AudioIn> &link : audioInLinks)
+        {
+          copyChannels(link.from, link.to);
+        }
+
+        for (GraphNode &node : nodes)
+        {
+          PortView<AudioIn> audioIns = node.engine->getAudioIns();
+          if (node.oversampling > 1)
+          {
+            // Run the frame as a block of one through the converters, leaving the
+            // result on the node's outputs for whatever reads them.
+            for (size_t i = 0; i < audioIns.size(); i++)
+            {
+              Port<float> *source = node.audioIns[i].source;
+              node.frameIns[i] = source ? source->getValue() : 0.f;
+              node.audioInBlocks[i] = &node.frameIns[i];
+            }
+            for (size_t i = 0; i < node.frameOuts.size(); i++)
+            {
+              node.audioOutBlocks[i] = &node.frameOuts[i];
+            }
+            processOversampled(node, frameInfo, 1);
+            PortView<AudioOut> audioOuts = node.engine->getAudioOuts();
+            for (size_t i = 0; i < audioOuts.size(); i++)
+            {
+              audioOuts[i]->setValue(node.frameOuts[i]);
+            }
+          }
+          else
+          {
+            for (size_t i = 0; i < audioIns.size(); i++)
+            {
+              Port<float> *source = node.audioIns[i].source;
+              audioIns[i]->setValue(source ? source->getValue() : 0.f);
+            }
+            node.engine->doProcess(frameInfo);
+          }
+
+          passOn(node.cvLinks);
+          passOn(node.gateLinks);
+        }
+
+        for (PortLink<AudioOut, AudioOut> &link : audioOutLinks)
+        {
+          link.to->setValue(link.from->getValue());
+          copyChannels(link.from, link.to);
+        }
+        passOn(cvOutLinks);
+        passOn(gateOutLinks);
+      }
+
+      void processBlock(FrameInfo frameInfo, size_t numFrames) override
+      {
+        for (AudioOut *audioOut : unlinkedAudioOuts)
+        {
+          std::fill(audioOut->getBlock(), audioOut->getBlock() + numFrames, 0.f);
+        }
+
+        chunkFrameInfo = frameInfo;
+        for (chunkFrame = 0; chunkFrame < numFrames; chunkFrame += GRAPH_MAX_BLOCK_SIZE)
+        {
+          numChunkFrames = std::min(GRAPH_MAX_BLOCK_SIZE, numFrames - chunkFrame);
+          if (scheduler)
+          {
+            scheduler->runNodes(*this);
+          }
+          else
+          {
+            for (size_t i = 0; i < nodes.size(); i++)
+            {
+              runNode(i);
+            }
+          }
+        }
+
+        passOn(cvOutLinks);
+        passOn(gateOutLinks);
+      }
+
+      bool canSleepWhenSilent() override
+      {
+        return false;
+      }
+
+      bool isIdle() override
+      {
+        for (GraphNode &node : nodes)
+        {
+          if (!node.engine->isSleeping())
+          {
+            return false;
+          }
+        }
+        return !nodes.empty();
+      }
+
+    private:
+      /**
+       * @brief Process node `index` for the current chunk. Only touches the node, its
+       * blocks, and the inputs of the nodes connected from it.
+       */
+      void runNode(size_t index) override
+      {
+        GraphNode &node = nodes[index];
+        for (size_t i = 0; i < node.audioIns.size(); i++)
+        {
+          node.audioInBlocks[i] = node.audioIns[i].getInBlock(chunkFrame);
+        }
+        for (size_t i = 0; i < node.audioOuts.size(); i++)
+        {
+          node.audioOutBlocks[i] = node.audioOuts[i].getOutBlock(chunkFrame);
+        }
+
+        if (node.oversampling > 1)
+        {
+          processOversampled(node, chunkFrameInfo, numChunkFrames);
+        }
+        else
+        {
+          node.engine->doProcessBlock(chunkFrameInfo, numChunkFrames, node.audioInBlocks.data(), node.audioOutBlocks.data());
+        }
+
+        passOn(node.cvLinks);
+        passOn(node.gateLinks);
+      }
+
+      /**
+       * @brief Process `numFrames` frames of the node's base-rate blocks
+       * (`audioInBlocks`/`audioOutBlocks`) at its oversampled rate.
+       */
+      static void processOversampled(GraphNode &node, FrameInfo frameInfo, size_t numFrames)
+      {
+        size_t factor = node.oversampling;
+        for (size_t i = 0; i < node.upsamplers.size(); i++)
+        {
+          node.upsamplers[i].upsample(node.audioInBlocks[i], numFrames, node.oversampledIns[i].data());
+          node.oversampledInBlocks[i] = node.oversampledIns[i].data();
+        }
+        for (size_t i = 0; i < node.downsamplers.size(); i++)
+        {
+          node.oversampledOutBlocks[i] = node.oversampledOuts[i].data();
+        }
+
+        FrameInfo oversampledFrameInfo = {frameInfo.sampleRate * factor, frameInfo.sampleTime / factor};
+        node.engine->doProcessBlock(oversampledFrameInfo, numFrames * factor, node.oversampledInBlocks.data(), node.oversampledOutBlocks.data());
+
+        for (size_t i = 0; i < node.downsamplers.size(); i++)
+        {
+          node.downsamplers[i].downsample(node.oversampledOuts[i].data(), numFrames, node.audioOutBlocks[i]);
+        }
+      }
+
+      template <class TFrom, class TTo>
+      static void passOn(std::vector<PortLink<TFrom, TTo>> &links)
+      {
+        for (PortLink<TFrom, TTo> &link : links)
+        {
+          if (link.from->getGeneration() != link.sentGeneration)
+          {
+            // Scheduling always keeps the newest value (see
+            // `InputPort::scheduleValue()`), so the change is sent once delivered.
+            link.sentGeneration = link.from->getGeneration();
+            deliver(link.to, link.from->getValue());
+          }
+        }
+      }
+
+      static void deliver(CVIn *port, float value)
+      {
+        port->scheduleValue(value, 0);
+      }
+
+      static void deliver(GateIn *port, bool value)
+      {
+        port->scheduleValue(value, 0);
+      }
+
+      static void deliver(CVOut *port, float value)
+      {
+        port->setValue(value);
+      }
+
+      static void deliver(GateOut *port, bool value)
+      {
+        port->setValue(value);
+      }
+
+      template <class TFrom, class TTo>
+      static void copyChannels(TFrom *from, TTo *to)
+      {
+        if (to->isPolyphonic())
+        {
+          to->setChannels(from->getChannels());
+          std::copy(from->getChannelValues(), from->getChannelValues() + MAX_CHANNELS, to->getChannelValues());
+        }
+      }
+
+      template <class T, class TPort>
+      static bool contains(PortView<T> ports, TPort *port)
+      {
+        for (T *p : ports)
+        {
+          if (p == port)
+          {
+            return true;
+          }
+        }
+        return false;
+      }
+
+      static bool hasPort(Engine *engine, AudioIn *port)
+      {
+        return contains(engine->getAudioIns(), port);
+      }
+
+      static bool hasPort(Engine *engine, AudioOut *port)
+      {
+        return contains(engine->getAudioOuts(), port);
+      }
+
+      static bool hasPort(Engine *engine, CVIn *port)
+      {
+        return contains(engine->getCVIns(), port) || contains(engine->getParams(), port);
+      }
+
+      static bool hasPort(Engine *engine, CVOut *port)
+      {
+        return contains(engine->getCVOuts(), port) || contains(engine->getLights(), port);
+      }
+
+      static bool hasPort(Engine *engine, GateIn *port)
+      {
+        return contains(engine->getGateIns(), port);
+      }
+
+      static bool hasPort(Engine *engine, GateOut *port)
+      {
+        return contains(engine->getGateOuts(), port);
+      }
+
+      template <class TPort>
+      size_t findNodeIndex(TPort *port)
+      {
+        size_t i = 0;
+        while (i < nodes.size() && !hasPort(nodes[i].engine, port))
+        {
+          i++;
+        }
+        assert(i < nodes.size() && "Port doesn't belong to a node of this graph");
+        return i;
+      }
+
+      template <class TPort>
+      GraphNode &findNode(TPort *port)
+      {
+        return nodes[findNodeIndex(port)];
+      }
+
+      /**
+       * @brief Whether a CV input already has a source.
+       */
+      bool hasSource(CVIn *nodeIn)
+      {
+        bool found = false;
+        for (PortLink<CVIn, CVIn> &link : cvInLinks)
+        {
+          found |= link.to == nodeIn;
+        }
+        for (GraphNode &node : nodes)
+        {
+          for (PortLink<CVOut, CVIn> &link : node.cvLinks)
+          {
+            found |= link.to == nodeIn;
+          }
+        }
+        return found;
+      }
+
+      /**
+       * @brief Whether a gate input already has a source.
+       */
+      bool hasSource(GateIn *nodeIn)
+      {
+        bool found = false;
+        for (PortLink<GateIn, GateIn> &link : gateInLinks)
+        {
+          found |= link.to == nodeIn;
+        }
+        for (GraphNode &node : nodes)
+        {
+          for (PortLink<GateOut, GateIn> &link : node.gateLinks)
+          {
+            found |= link.to == nodeIn;
+          }
+        }
+        return found;
+      }
+
+      /**
+       * @brief The node output connected to `nodeIn`, or NULL. Inputs connected to a
+       * graph input have the graph input as their source.
+       */
+      Port<float> *findAudioSource(AudioIn *nodeIn)
+      {
+        for (PortLink<AudioIn, AudioIn> &link : audioInLinks)
+        {
+          if (link.to == nodeIn)
+          {
+            return link.from;
+          }
+        }
+        for (PortLink<AudioOut, AudioIn> &link : audioLinks)
+        {
+          if (link.to == nodeIn)
+          {
+            return link.from;
+          }
+        }
+        return NULL;
+      }
+
+      /**
+       * @brief Put the nodes in an order where every node comes after the nodes it
+       * is connected from, keeping the order they were added in where there is a
+       * choice.
+       */
+      void sortNodes()
+      {
+        size_t numNodes = nodes.size();
+        std::vector<std::vector<size_t>> edges(numNodes);
+        for (PortLink<AudioOut, AudioIn> &link : audioLinks)
+        {
+          edges[findNodeIndex(link.from)].push_back(findNodeIndex(link.to));
+        }
+        for (size_t i = 0; i < numNodes; i++)
+        {
+          for (PortLink<CVOut, CVIn> &link : nodes[i].cvLinks)
+          {
+            edges[i].push_back(findNodeIndex(link.to));
+          }
+          for (PortLink<GateOut, GateIn> &link : nodes[i].gateLinks)
+          {
+            edges[i].push_back(findNodeIndex(link.to));
+          }
+        }
+
+        std::vector<size_t> numSources(numNodes, 0);
+        for (std::vector<size_t> &targets : edges)
+        {
+          for (size_t target : targets)
+          {
+            numSources[target]++;
+          }
+        }
+
+        std::vector<GraphNode> sorted;
+        std::vector<size_t> sortedIndexes(numNodes);
+        std::vector<bool> isSorted(numNodes, false);
+        while (sorted.size() < numNodes)
+        {
+          size_t i = 0;
+          while (i < numNodes && (isSorted[i] || numSources[i] > 0))
+          {
+            i++;
+          }
+          assert(i < numNodes && "EngineGraph connections form a cycle");
+
+          isSorted[i] = true;
+          sortedIndexes[i] = sorted.size();
+          sorted.push_back(nodes[i]);
+          for (size_t target : edges[i])
+          {
+            numSources[target]--;
+          }
+        }
+        nodes = sorted;
+
+        dependents.assign(numNodes, std::vector<size_t>());
+        for (size_t i = 0; i < numNodes; i++)
+        {
+          for (size_t target : edges[i])
+          {
+            dependents[sortedIndexes[i]].push_back(sortedIndexes[target]);
+          }
+        }
+        if (scheduler)
+        {
+          scheduler->setDependencies(dependents);
+        }
+
+        assignBlocks();
+      }
+
+      /**
+       * @brief Decide where every node port reads and writes its audio, allocating the
+       * intermediate buffers. Running in order, a buffer is reused once the last
+       * node reading it has run, but never by that node's own outputs. With a
+       * scheduler, every output gets its own buffer.
+       */
+      void assignBlocks()
+      {
+        bool shareBuffers = !scheduler;
+        std::vector<size_t> bufferIndexes;     // Per node output, in node order.
+        std::vector<size_t> lastReaders(2, 0); // Per buffer, the last node to read it.
+        std::vector<size_t> freeBuffers;
+
+        for (size_t i = 0; i < nodes.size(); i++)
+        {
+          for (AudioOut *nodeOut : nodes[i].engine->getAudioOuts())
+          {
+            size_t lastReader = 0;
+            for (PortLink<AudioOut, AudioIn> &link : audioLinks)
+            {
+              if (link.from == nodeOut)
+              {
+                lastReader = std::max(lastReader, findNodeIndex(link.to));
+              }
+            }
+
+            size_t index = 1; // Scratch.
+            if ((lastReader > 0 || !shareBuffers) && !findGraphOut(nodeOut))
+            {
+              if (freeBuffers.empty() || !shareBuffers)
+              {
+                index = lastReaders.size();
+                lastReaders.push_back(lastReader);
+              }
+              else
+              {
+                index = freeBuffers.back();
+                freeBuffers.pop_back();
+                lastReaders[index] = lastReader;
+              }
+            }
+            bufferIndexes.push_back(index);
+          }
+
+          for (size_t index = 2; index < lastReaders.size(); index++)
+          {
+            if (lastReaders[index] == i)
+            {
+              freeBuffers.push_back(index);
+              lastReaders[index] = 0;
+            }
+          }
+        }
+
+        buffers.assign(lastReaders.size(), std::vector<float>(GRAPH_MAX_BLOCK_SIZE, 0.f));
+
+        size_t outIndex = 0;
+        for (GraphNode &node : nodes)
+        {
+          node.audioOuts.clear();
+          for (AudioOut *nodeOut : node.engine->getAudioOuts())
+          {
+            node.audioOuts.push_back({NULL, findGraphOut(nodeOut), buffers[bufferIndexes[outIndex++]].data(), NULL});
+          }
+          node.audioOutBlocks.assign(node.audioOuts.size(), NULL);
+        }
+
+        for (GraphNode &node : nodes)
+        {
+          node.audioIns.clear();
+          for (AudioIn *nodeIn : node.engine->getAudioIns())
+          {
+            GraphBlock block = {NULL, NULL, buffers[0].data(), findAudioSource(nodeIn)};
+            for (PortLink<AudioIn, AudioIn> &link : audioInLinks)
+            {
+              block.graphIn = link.to == nodeIn ? link.from : block.graphIn;
+            }
+            for (PortLink<AudioOut, AudioIn> &link : audioLinks)
+            {
+              if (link.to == nodeIn)
+              {
+                block = findNode(link.from).audioOuts[findPortIndex(link.from)];
+                block.source = link.from;
+              }
+            }
+            node.audioIns.push_back(block);
+          }
+          node.audioInBlocks.assign(node.audioIns.size(), NULL);
+        }
+
+        unlinkedAudioOuts.clear();
+        for (AudioOut *graphOut : this->getAudioOuts())
+        {
+          bool isLinked = false;
+          for (PortLink<AudioOut, AudioOut> &link : audioOutLinks)
+          {
+            isLinked |= link.to == graphOut;
+          }
+          if (!isLinked)
+          {
+            unlinkedAudioOuts.push_back(graphOut);
+          }
+        }
+      }
+
+      AudioOut *findGraphOut(AudioOut *nodeOut)
+      {
+        for (PortLink<AudioOut, AudioOut> &link : audioOutLinks)
+        {
+          if (link.from == nodeOut)
+          {
+            return link.to;
+          }
+        }
+        return NULL;
+      }
+
+      size_t findPortIndex(AudioOut *nodeOut)
+      {
+        PortView<AudioOut> audioOuts = findNode(nodeOut).engine->getAudioOuts();
+        size_t i = 0;
+        while (audioOuts[i] != nodeOut)
+        {
+          i++;
+        }
+        return i;
+      }
+    };
+  }
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "EngineGraph.hpp"
+
+namespace phnq
+{
+  namespace engine
+  {
+    /**
+     * @brief Runs a StaticEngine at `Factor` (2, 4 or 8) times the adapter's sample
+     * rate, as a one-node EngineGraph with the same schema, port ids and port order
+     * as the engine. It can be used anywhere the engine can, e.g.
+     * `createSeedEngine<Oversampled<PolyVox, 2>>()`. Audio is converted up and down
+     * around the engine, so nonlinear or fast-moving DSP aliases less, at roughly
+     * `Factor` times the engine's CPU cost plus the filters. Control ports run at
+     * the adapter's rate.
+     *
+     * Outputs are mono even where the engine's are polyphonic, since only the
+     * summed signal goes through the decimators. The converters delay audio by
+     * `getLatency()` frames, which is not compensated, so audio lags the engine's
+     * CV and gate outputs by that much. The engine sleeps as usual when idle
+     * (e.g. PolyVox with no notes), and then so does this graph.
+     */
+    template <class TEngine, size_t Factor>
+    struct Oversampled : EngineGraph<typename TEngine::Schema>
+    {
+      TEngine *engine = this->addNode(new TEngine(), Factor);
+
+      Oversampled()
+      {
+        for (AudioIn *port : engine->getAudioIns())
+        {
+          this->connect(this->createAudioIn(port->getId()), port);
+        }
+        for (AudioOut *port : engine->getAudioOuts())
+        {
+          this->connect(port, this->createAudioOut(port->getId()));
+        }
+        for (CVIn *port : engine->getCVIns())
+        {
+          this->connect(this->createCVIn(port->getId()), port);
+        }
+        for (CVOut *port : engine->getCVOuts())
+        {
+          this->connect(port, this->createCVOut(port->getId()));
+        }
+        for (GateIn *port : engine->getGateIns())
+        {
+          GateIn *graphIn = this->createGateIn(port->getId());
+          graphIn->setType(port->getType());
+          this->connect(graphIn, port);
+        }
+        for (GateOut *port : engine->getGateOuts())
+        {
+          this->connect(port, this->createGateOut(port->getId()));
+        }
+        for (Param *port : engine->getParams())
+        {
+          if (port->getType() == Param::BUTTON)
+          {
+            this->connect(this->createButton(port->getId()), port);
+          }
+          else
+          {
+            this->connect(this->createParam(port->getId()), port);
+          }
+        }
+        for (Light *port : engine->getLights())
+        {
+          this->connect(port, this->createLight(port->getId()));
+        }
+      }
+
+      /**
+       * @brief How far audio outputs lag, in adapter frames: through the decimators,
+       * and through the upsamplers too for engines with audio inputs.
+       */
+      float getLatency()
+      {
+        float upsamplerLatency = engine->getAudioIns().size() > 0 ? Oversampler::getLatency(Factor, false) : 0.f;
+        return upsamplerLatency + Oversampler::getLatency(Factor, true);
+      }
+    };
+  }
+}
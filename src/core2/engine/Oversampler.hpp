@@ -0,0 +1,218 @@
+#pragma once
+
+#include <assert.h>
+#include <stddef.h>
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+namespace phnq
+{
+  namespace engine
+  {
+    // Side taps per half of the half-band filter next to the base rate, where the
+    // transition band is narrowest, and of the stages further out.
+    const size_t HALF_BAND_BASE_TAPS = 12;
+    const size_t HALF_BAND_OUTER_TAPS = 4;
+
+    /**
+     * @brief One 2x stage: a windowed-sinc half-band lowpass, run in polyphase form.
+     * Every other tap of a half-band filter is zero and the center tap is 0.5, so
+     * upsampling produces one sample as a plain delay and the other from the
+     * `numTaps` symmetric side taps, and decimating only computes the kept
+     * samples.
+     */
+    struct HalfBandStage
+    {
+    private:
+      std::vector<float> coefs;   // Side taps, nearest the center first; they sum to 0.25.
+      std::vector<float> history; // Double-written ring, so the window is contiguous.
+      size_t historySize = 0;
+      size_t pos = 0;
+
+      void push(float sample)
+      {
+        pos = pos + 1 == historySize ? 0 : pos + 1;
+        history[pos] = sample;
+        history[pos + historySize] = sample;
+      }
+
+      // Oldest to newest, `historySize` samples.
+      const float *getWindow()
+      {
+        return &history[pos + 1];
+      }
+
+    public:
+      /**
+       * @param numTaps side taps per half; the filter has 4 * numTaps - 1 taps.
+       * @param isDecimator whether the stage decimates (or else upsamples).
+       */
+      void init(size_t numTaps, bool isDecimator)
+      {
+        size_t length = 4 * numTaps - 1;
+        coefs.assign(numTaps, 0.f);
+        float sum = 0.f;
+        for (size_t j = 1; j <= numTaps; j++)
+        {
+          // Offset 2j - 1 from the center, Blackman window over the full filter.
+          float k = (float)(2 * j - 1);
+          float phase = 2.f * (float)M_PI * ((float)(2 * numTaps - 1) + k) / (float)(length - 1);
+          float window = 0.42f - 0.5f * cosf(phase) + 0.08f * cosf(2.f * phase);
+          coefs[j - 1] = sinf((float)M_PI * k / 2.f) / ((float)M_PI * k) * window;
+          sum += coefs[j - 1];
+        }
+        for (float &coef : coefs)
+        {
+          coef *= 0.25f / sum;
+        }
+
+        historySize = isDecimator ? 4 * numTaps - 1 : 2 * numTaps;
+        history.assign(2 * historySize, 0.f);
+        pos = 0;
+      }
+
+      /**
+       * @brief Produce `2 * numFrames` samples from `numFrames`, delayed by
+       * `numTaps` input samples.
+       */
+      void upsample(const float *in, size_t numFrames, float *out)
+      {
+        size_t numTaps = coefs.size();
+        for (size_t frame = 0; frame < numFrames; frame++)
+        {
+          push(in[frame]);
+          const float *window = getWindow();
+          float mid = 0.f;
+          for (size_t j = 1; j <= numTaps; j++)
+          {
+            mid += coefs[j - 1] * (window[numTaps - 1 + j] + window[numTaps - j]);
+          }
+          out[2 * frame] = window[numTaps - 1];
+          out[2 * frame + 1] = 2.f * mid;
+        }
+      }
+
+      /**
+       * @brief Produce `numFrames` samples from `2 * numFrames`.
+       */
+      void downsample(const float *in, size_t numFrames, float *out)
+      {
+        size_t numTaps = coefs.size();
+        for (size_t frame = 0; frame < numFrames; frame++)
+        {
+          push(in[2 * frame]);
+          push(in[2 * frame + 1]);
+          const float *window = getWindow();
+          float sum = 0.5f * window[2 * numTaps - 1];
+          for (size_t j = 1; j <= numTaps; j++)
+          {
+            sum += coefs[j - 1] * (window[2 * numTaps - 2 + 2 * j] + window[2 * numTaps - 2 * j]);
+          }
+          out[frame] = sum;
+        }
+      }
+    };
+
+    /**
+     * @brief Converts one signal to and from 2x, 4x or 8x its rate with a cascade of
+     * half-band stages. The stage next to the base rate has the sharpest filter;
+     * the outer ones only have to reject images far above the base band, so they
+     * are shorter. Scratch space is allocated by `init()`, so converting never
+     * allocates. Use one Oversampler per signal and direction, since each holds
+     * its filter state.
+     */
+    struct Oversampler
+    {
+    private:
+      std::vector<HalfBandStage> stages; // Nearest the base rate first.
+      std::vector<float> scratch;
+      size_t factor = 1;
+
+    public:
+      /**
+       * @param factor 1, 2, 4 or 8.
+       * @param maxFrames most base-rate frames converted at once.
+       * @param isDecimator whether this converts down (or else up).
+       */
+      void init(size_t factor, size_t maxFrames, bool isDecimator)
+      {
+        assert((factor == 1 || factor == 2 || factor == 4 || factor == 8) && "Oversampling factor must be 1, 2, 4 or 8");
+        this->factor = factor;
+        stages.clear();
+        for (size_t stageFactor = 2; stageFactor <= factor; stageFactor *= 2)
+        {
+          HalfBandStage stage;
+          stage.init(stageFactor == 2 ? HALF_BAND_BASE_TAPS : HALF_BAND_OUTER_TAPS, isDecimator);
+          stages.push_back(stage);
+        }
+        scratch.assign(maxFrames * factor, 0.f);
+      }
+
+      size_t getFactor()
+      {
+        return factor;
+      }
+
+      /**
+       * @brief How far a signal converted by `factor` lags, in base-rate frames. Each
+       * stage delays by its side taps when upsampling, and by one less when
+       * decimating, counted at its input and output rate respectively: 12, 14 or
+       * 15 frames up and 11, 12.5 or 13.25 down at 2x, 4x and 8x.
+       */
+      static float getLatency(size_t factor, bool isDecimator)
+      {
+        float latency = 0.f;
+        for (size_t stageFactor = 2; stageFactor <= factor; stageFactor *= 2)
+        {
+          size_t numTaps = stageFactor == 2 ? HALF_BAND_BASE_TAPS : HALF_BAND_OUTER_TAPS;
+          latency += (float)(isDecimator ? numTaps - 1 : numTaps) * 2.f / (float)stageFactor;
+        }
+        return latency;
+      }
+
+      /**
+       * @brief Convert `numFrames` base-rate samples to `numFrames * getFactor()`.
+       */
+      void upsample(const float *in, size_t numFrames, float *out)
+      {
+        // Alternate between `out` and scratch so the last stage lands in `out`.
+        size_t numStages = stages.size();
+        const float *stageIn = in;
+        for (size_t i = 0; i < numStages; i++)
+        {
+          float *stageOut = (numStages - 1 - i) % 2 == 0 ? out : scratch.data();
+          stages[i].upsample(stageIn, numFrames << i, stageOut);
+          stageIn = stageOut;
+        }
+        if (numStages == 0)
+        {
+          std::copy(in, in + numFrames, out);
+        }
+      }
+
+      /**
+       * @brief Convert `numFrames * getFactor()` samples back to `numFrames` at the
+       * base rate.
+       */
+      void downsample(const float *in, size_t numFrames, float *out)
+      {
+        // Intermediate rates fit in alternate halves of scratch.
+        size_t numStages = stages.size();
+        float *halves[] = {scratch.data(), scratch.data() + scratch.size() / 2};
+        const float *stageIn = in;
+        for (size_t i = 0; i < numStages; i++)
+        {
+          size_t stage = numStages - 1 - i;
+          float *stageOut = stage == 0 ? out : halves[i % 2];
+          stages[stage].downsample(stageIn, numFrames << stage, stageOut);
+          stageIn = stageOut;
+        }
+        if (numStages == 0)
+        {
+          std::copy(in, in + numFrames, out);
+        }
+      }
+    };
+  }
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <stddef.h>
+#include <math.h>
+#include "ports/CVIn.hpp"
+
+namespace phnq
+{
+  namespace engine
+  {
+    const size_t MAX_SMOOTHED_PORTS = 16;
+
+    /**
+     * @brief One-pole smoothing for the CVIn/Param ports that opt in with
+     * `setSmoothing()`. Targets and current values are kept in parallel arrays, so
+     * a whole block's worth of smoothing is one pass over all smoothed ports. Ports
+     * only see their value change once per block, so engines can read it at
+     * control rate. Once every port has reached its target, `process()` returns
+     * right away.
+     */
+    struct ParamSmoother
+    {
+    private:
+      alignas(16) float targets[MAX_SMOOTHED_PORTS] = {};
+      alignas(16) float values[MAX_SMOOTHED_PORTS] = {};
+      alignas(16) float frameCoefs[MAX_SMOOTHED_PORTS] = {};
+      alignas(16) float blockCoefs[MAX_SMOOTHED_PORTS] = {};
+      CVIn *ports[MAX_SMOOTHED_PORTS] = {};
+      size_t numPorts = 0;
+      size_t blockCoefFrames = 0; // Block size `blockCoefs` were computed for.
+
+    public:
+      /**
+       * @brief Take over smoothing for `port`. From now on its `setValue()` only sets
+       * the target.
+       *
+       * @return false if `MAX_SMOOTHED_PORTS` ports are already smoothed.
+       */
+      bool add(CVIn *port)
+      {
+        if (numPorts == MAX_SMOOTHED_PORTS)
+        {
+          return false;
+        }
+        values[numPorts] = port->getValue();
+        port->bindSmoothingTarget(&targets[numPorts]);
+        ports[numPorts++] = port;
+        return true;
+      }
+
+      void setSampleRate(float sampleRate)
+      {
+        for (size_t i = 0; i < numPorts; i++)
+        {
+          frameCoefs[i] = expf(-1.f / (ports[i]->getSmoothingTime() * sampleRate));
+        }
+        blockCoefFrames = 0;
+      }
+
+      /**
+       * @brief Advance all smoothed ports by `numFrames` frames and write the new
+       * values to the ports.
+       */
+      void process(size_t numFrames)
+      {
+        // Unused slots have equal targets and values, so full-width loops are safe
+        // and let the compiler vectorize without a remainder.
+        bool settled = true;
+        for (size_t i = 0; i < MAX_SMOOTHED_PORTS; i++)
+        {
+          settled &= targets[i] == values[i];
+        }
+        if (settled)
+        {
+          return;
+        }
+
+        if (numFrames != blockCoefFrames)
+        {
+          for (size_t i = 0; i < MAX_SMOOTHED_PORTS; i++)
+          {
+            blockCoefs[i] = powf(frameCoefs[i], (float)numFrames);
+          }
+          blockCoefFrames = numFrames;
+        }
+
+        for (size_t i = 0; i < MAX_SMOOTHED_PORTS; i++)
+        {
+          float value = targets[i] + (values[i] - targets[i]) * blockCoefs[i];
+          values[i] = fabsf(value - targets[i]) > CV_CHANGE_THRESHOLD ? value : targets[i];
+        }
+
+        for (size_t i = 0; i < numPorts; i++)
+        {
+          ports[i]->Port<float>::setValue(values[i]);
+        }
+      }
+    };
+  }
+}
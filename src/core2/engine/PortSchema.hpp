@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include "ports/AudioIn.hpp"
+#include "ports/AudioOut.hpp"
+#include "ports/GateIn.hpp"
+#include "ports/GateOut.hpp"
+#include "ports/CVIn.hpp"
+#include "ports/CVOut.hpp"
+#include "ports/Param.hpp"
+#include "ports/Button.hpp"
+#include "ports/Light.hpp"
+
+namespace phnq
+{
+  namespace engine
+  {
+    /**
+     * @brief Compile-time declaration of how many ports of each kind an engine has.
+     * Adapters use the counts to size their tables and to compute host indexes
+     * without any lookups. Host indexes follow the same layout as before:
+     * - inputs: audio ins, then CV ins, then gate ins.
+     * - outputs: audio outs, then CV outs, then gate outs.
+     * - params: params and buttons together, in creation order.
+     * - lights: in creation order.
+     */
+    template <size_t NumAudioIns, size_t NumAudioOuts, size_t NumCVIns, size_t NumCVOuts, size_t NumGateIns, size_t NumGateOuts, size_t NumParams, size_t NumButtons, size_t NumLights>
+    struct PortSchema
+    {
+      enum : size_t
+      {
+        NUM_AUDIO_INS = NumAudioIns,
+        NUM_AUDIO_OUTS = NumAudioOuts,
+        NUM_CV_INS = NumCVIns,
+        NUM_CV_OUTS = NumCVOuts,
+        NUM_GATE_INS = NumGateIns,
+        NUM_GATE_OUTS = NumGateOuts,
+        NUM_PARAMS = NumParams,
+        NUM_BUTTONS = NumButtons,
+        NUM_LIGHTS = NumLights,
+
+        NUM_INPUTS = NumAudioIns + NumCVIns + NumGateIns,
+        NUM_OUTPUTS = NumAudioOuts + NumCVOuts + NumGateOuts,
+        NUM_ALL_PARAMS = NumParams + NumButtons,
+
+        AUDIO_IN_OFFSET = 0,
+        CV_IN_OFFSET = NumAudioIns,
+        GATE_IN_OFFSET = NumAudioIns + NumCVIns,
+        AUDIO_OUT_OFFSET = 0,
+        CV_OUT_OFFSET = NumAudioOuts,
+        GATE_OUT_OFFSET = NumAudioOuts + NumCVOuts,
+      };
+    };
+
+    /**
+     * @brief Hot port values for a PortSchema, one contiguous aligned array per
+     * signal class, indexed the same as the matching PortStorage array. Adapters
+     * can move values in and out of these arrays in bulk; `params` is indexed in
+     * creation order like `PortStorage::params`.
+     */
+    template <class TSchema>
+    struct PortValues
+    {
+      alignas(16) std::array<float, TSchema::NUM_AUDIO_INS> audioIns;
+      alignas(16) std::array<float, TSchema::NUM_AUDIO_OUTS> audioOuts;
+      alignas(16) std::array<float, TSchema::NUM_CV_INS> cvIns;
+      alignas(16) std::array<float, TSchema::NUM_CV_OUTS> cvOuts;
+      alignas(16) std::array<float, TSchema::NUM_ALL_PARAMS> params;
+      alignas(16) std::array<float, TSchema::NUM_LIGHTS> lights;
+      std::array<bool, TSchema::NUM_GATE_INS> gateIns;
+      std::array<bool, TSchema::NUM_GATE_OUTS> gateOuts;
+    };
+
+    /**
+     * @brief Fixed-capacity inline storage for the ports declared by a PortSchema.
+     * The ports hold cold metadata (ids, listeners, delay config) and act as handles
+     * to their values in PortValues.
+     * Params and buttons are stored separately since they are different types;
+     * `params` points into both in creation order.
+     */
+    template <class TSchema>
+    struct PortStorage
+    {
+      std::array<AudioIn, TSchema::NUM_AUDIO_INS> audioIns;
+      std::array<AudioOut, TSchema::NUM_AUDIO_OUTS> audioOuts;
+      std::array<CVIn, TSchema::NUM_CV_INS> cvIns;
+      std::array<CVOut, TSchema::NUM_CV_OUTS> cvOuts;
+      std::array<GateIn, TSchema::NUM_GATE_INS> gateIns;
+      std::array<GateOut, TSchema::NUM_GATE_OUTS> gateOuts;
+      std::array<Param, TSchema::NUM_PARAMS> paramSlots;
+      std::array<Button, TSchema::NUM_BUTTONS> buttonSlots;
+      std::array<Param *, TSchema::NUM_ALL_PARAMS> params;
+      std::array<Light, TSchema::NUM_LIGHTS> lights;
+    };
+  }
+}
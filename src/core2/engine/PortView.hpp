@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stddef.h>
+
+namespace phnq
+{
+  namespace engine
+  {
+    /**
+     * @brief Non-owning, read-only view of a list of ports, usable in range-based for
+     * loops and indexable like a vector. Views are a pointer and a count, so they
+     * cost nothing to return or copy. A view stays valid as long as the ports it
+     * was taken from aren't added to, which in practice means after the engine's
+     * constructor.
+     */
+    template <class T>
+    struct PortView
+    {
+      typedef T *const *iterator;
+
+    private:
+      iterator items;
+      size_t count;
+
+    public:
+      PortView(iterator items, size_t count) : items(items), count(count)
+      {
+      }
+
+      iterator begin() const
+      {
+        return items;
+      }
+
+      iterator end() const
+      {
+        return items + count;
+      }
+
+      size_t size() const
+      {
+        return count;
+      }
+
+      bool empty() const
+      {
+        return count == 0;
+      }
+
+      T *operator[](size_t index) const
+      {
+        return items[index];
+      }
+    };
+  }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stddef.h>
+#include <atomic>
+
+namespace phnq
+{
+  namespace engine
+  {
+    /**
+     * @brief Wait-free, fixed-capacity, single-producer/single-consumer queue. One
+     * thread (or the main loop) may push while another thread (or an interrupt)
+     * pops, with no locks and no interrupt masking. Nothing is allocated after
+     * construction.
+     *
+     * @tparam T item type, copied in and out.
+     * @tparam Capacity maximum number of queued items, a power of two.
+     */
+    template <class T, size_t Capacity>
+    struct SpscQueue
+    {
+      static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+    private:
+      T items[Capacity];
+      std::atomic<size_t> head; // Next item to pop; written by the consumer only.
+      std::atomic<size_t> tail; // Next slot to push; written by the producer only.
+
+    public:
+      SpscQueue() : head(0), tail(0)
+      {
+      }
+
+      /**
+       * @brief Producer side. Returns false, leaving the queue unchanged, if full.
+       */
+      bool push(const T &item)
+      {
+        size_t currentTail = tail.load(std::memory_order_relaxed);
+        if (currentTail - head.load(std::memory_order_acquire) == Capacity)
+        {
+          return false;
+        }
+        items[currentTail & (Capacity - 1)] = item;
+        tail.store(currentTail + 1, std::memory_order_release);
+        return true;
+      }
+
+      /**
+       * @brief Consumer side. Returns false if there is nothing to pop.
+       */
+      bool pop(T &item)
+      {
+        size_t currentHead = head.load(std::memory_order_relaxed);
+        if (currentHead == tail.load(std::memory_order_acquire))
+        {
+          return false;
+        }
+        item = items[currentHead & (Capacity - 1)];
+        head.store(currentHead + 1, std::memory_order_release);
+        return true;
+      }
+    };
+  }
+}
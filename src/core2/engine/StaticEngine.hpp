@@ -0,0 +1,160 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "Engine.hpp"
+#include "PortSchema.hpp"
+
+namespace phnq
+{
+  namespace engine
+  {
+    /**
+     * @brief An Engine whose ports are declared at compile time by a PortSchema.
+     * The `create*()` methods hand out slots from inline fixed-size arrays instead
+     * of allocating, binding each port's value into PortValues. Adapters can use
+     * `TEngine::Schema`, `getPortStorage()` and `getPortValues()` to move values
+     * with no lookups. Creating more ports of a kind than the schema declares
+     * stops the program, in release builds too, as does creating fewer (checked
+     * by `checkSchemaComplete()` in the adapters).
+     */
+    template <class TSchema>
+    struct StaticEngine : Engine
+    {
+      typedef TSchema Schema;
+
+    private:
+      PortValues<TSchema> values = PortValues<TSchema>();
+      PortStorage<TSchema> ports;
+      size_t numAudioIns = 0;
+      size_t numAudioOuts = 0;
+      size_t numCVIns = 0;
+      size_t numCVOuts = 0;
+      size_t numGateIns = 0;
+      size_t numGateOuts = 0;
+      size_t numParams = 0;
+      size_t numButtons = 0;
+      size_t numLights = 0;
+
+      /**
+       * @brief A port count that doesn't match the schema is a bug in the engine,
+       * and carrying on would write past the port arrays, so stop.
+       */
+      static void failSchema(const std::string &message)
+      {
+        PHNQ_LOG("%s", message.c_str());
+        fflush(stdout);
+        abort();
+      }
+
+      template <class TPort, class TValue, size_t N>
+      TPort *createPort(std::array<TPort, N> &slots, std::array<TValue, N> &slotValues, size_t &count, std::string id)
+      {
+        if (count >= N)
+        {
+          failSchema("More ports created than declared in the PortSchema: " + id);
+        }
+        TPort *port = &slots[count];
+        port->bindValue(&slotValues[count]);
+        count++;
+        return addPort(port, id);
+      }
+
+      template <class TParam, size_t N>
+      TParam *createParamPort(std::array<TParam, N> &slots, size_t &count, std::string id)
+      {
+        if (count >= N)
+        {
+          failSchema("More ports created than declared in the PortSchema: " + id);
+        }
+        TParam *param = &slots[count++];
+        size_t index = numParams + numButtons - 1;
+        param->bindValue(&values.params[index]);
+        ports.params[index] = param;
+        return addPort(param, id);
+      }
+
+    public:
+      PortValues<TSchema> &getPortValues()
+      {
+        return values;
+      }
+
+      PortStorage<TSchema> &getPortStorage()
+      {
+        return ports;
+      }
+
+      bool isSchemaComplete()
+      {
+        return numAudioIns == TSchema::NUM_AUDIO_INS &&
+               numAudioOuts == TSchema::NUM_AUDIO_OUTS &&
+               numCVIns == TSchema::NUM_CV_INS &&
+               numCVOuts == TSchema::NUM_CV_OUTS &&
+               numGateIns == TSchema::NUM_GATE_INS &&
+               numGateOuts == TSchema::NUM_GATE_OUTS &&
+               numParams == TSchema::NUM_PARAMS &&
+               numButtons == TSchema::NUM_BUTTONS &&
+               numLights == TSchema::NUM_LIGHTS;
+      }
+
+      /**
+       * @brief Stop unless every port the schema declares was created. Adapters call
+       * this once the engine is constructed.
+       */
+      void checkSchemaComplete()
+      {
+        if (!isSchemaComplete())
+        {
+          failSchema("Engine created fewer ports than its PortSchema declares");
+        }
+      }
+
+    protected:
+      AudioIn *createAudioIn(std::string id)
+      {
+        return createPort(ports.audioIns, values.audioIns, numAudioIns, id);
+      }
+
+      AudioOut *createAudioOut(std::string id)
+      {
+        return createPort(ports.audioOuts, values.audioOuts, numAudioOuts, id);
+      }
+
+      CVIn *createCVIn(std::string id)
+      {
+        return createPort(ports.cvIns, values.cvIns, numCVIns, id);
+      }
+
+      CVOut *createCVOut(std::string id)
+      {
+        return createPort(ports.cvOuts, values.cvOuts, numCVOuts, id);
+      }
+
+      GateIn *createGateIn(std::string id)
+      {
+        return createPort(ports.gateIns, values.gateIns, numGateIns, id);
+      }
+
+      GateOut *createGateOut(std::string id)
+      {
+        return createPort(ports.gateOuts, values.gateOuts, numGateOuts, id);
+      }
+
+      Param *createParam(std::string id)
+      {
+        return createParamPort(ports.paramSlots, numParams, id);
+      }
+
+      Button *createButton(std::string id)
+      {
+        return createParamPort(ports.buttonSlots, numButtons, id);
+      }
+
+      Light *createLight(std::string id)
+      {
+        return createPort(ports.lights, values.lights, numLights, id);
+      }
+    };
+  }
+}
@@ -1,13 +1,33 @@
 #pragma once
 
 #include "Port.hpp"
+#include "Channels.hpp"
 
 namespace phnq
 {
   namespace engine
   {
-    struct AudioIn : Port<float>
+    struct AudioIn : Port<float>, Channels<AudioIn>
     {
+    private:
+      const float *block = NULL;
+
+    public:
+      /**
+       * @brief Get the sample buffer for the block currently being processed. Only
+       * valid inside `Engine::processBlock()`.
+       *
+       * @return const float* `numFrames` input samples.
+       */
+      const float *getBlock()
+      {
+        return this->block;
+      }
+
+      void setBlock(const float *block)
+      {
+        this->block = block;
+      }
     };
   }
 }
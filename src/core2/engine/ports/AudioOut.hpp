@@ -1,17 +1,39 @@
 #pragma once
 
 #include "Port.hpp"
+#include "Channels.hpp"
 
 namespace phnq
 {
   namespace engine
   {
-    struct AudioOut : Port<float>
+    struct AudioOut : Port<float>, Channels<AudioOut>
     {
+    private:
+      float *block = NULL;
+
+    public:
       void setValue(float value) override
       {
         Port::setValue(daisysp::fclamp(value, -2.f, 2.f));
       }
+
+      /**
+       * @brief Get the sample buffer for the block currently being processed. Only
+       * valid inside `Engine::processBlock()`. Engines writing to the buffer directly
+       * are responsible for clamping to +/-2.0.
+       *
+       * @return float* `numFrames` output samples.
+       */
+      float *getBlock()
+      {
+        return this->block;
+      }
+
+      void setBlock(float *block)
+      {
+        this->block = block;
+      }
     };
   }
 }
@@ -29,20 +29,21 @@ namespace phnq
         setValue(value ? 1.f : 0.f);
       }
 
-      void setValue(float value) override
+      Type getType() override
+      {
+        return BUTTON;
+      }
+
+    protected:
+      void applyValue(float value) override
       {
         if (value != getValue() && this->listener)
         {
-          Param::setValue(value);
+          Param::applyValue(value);
           this->listener->buttonValueDidChange(this, this->getStepValue() == 1);
         }
       }
 
-      Type getType() override
-      {
-        return BUTTON;
-      }
-
     private:
       ButtonChangeListener *listener = NULL;
     };
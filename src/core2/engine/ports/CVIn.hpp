@@ -1,25 +1,39 @@
 #pragma once
 
 #include "Port.hpp"
+#include "Channels.hpp"
 
 namespace phnq
 {
   namespace engine
   {
-    struct CVIn : Port<float>
+    struct CVIn : InputPort<float>, Channels<CVIn>
     {
       struct CVInChangeListener
       {
         virtual void cvInValueDidChange(CVIn *port, float value){};
       };
 
-      void setValue(float value) override
+    protected:
+      /**
+       * @brief Take on the value, or for a smoothed port the value it moves towards.
+       * Listeners are called with the new (target) value.
+       */
+      void applyValue(float value) override
       {
         value = daisysp::fclamp(value, -1.f, 1.f);
 
-        if (abs(this->getValue() - value) > CV_CHANGE_THRESHOLD)
+        if (abs(this->getTargetValue() - value) > CV_CHANGE_THRESHOLD)
         {
-          Port::setValue(value);
+          if (this->smoothingTarget)
+          {
+            *this->smoothingTarget = value;
+            bumpGeneration();
+          }
+          else
+          {
+            InputPort::applyValue(value);
+          }
           if (this->listener)
           {
             this->listener->cvInValueDidChange(this, value);
@@ -27,14 +41,54 @@ namespace phnq
         }
       }
 
+    public:
       virtual CVIn *setListener(CVInChangeListener *listener)
       {
         this->listener = listener;
         return this;
       }
 
+      /**
+       * @brief Opt in to smoothing. Value changes are then approached exponentially,
+       * updated once per processed block, instead of taking effect at once. Set
+       * this when creating the port.
+       *
+       * @param seconds time constant, the time to cover ~63% of a change.
+       * @return CVIn* for chainability.
+       */
+      virtual CVIn *setSmoothing(float seconds)
+      {
+        this->smoothingTime = seconds;
+        return this;
+      }
+
+      float getSmoothingTime()
+      {
+        return this->smoothingTime;
+      }
+
+      /**
+       * @brief The value the port is moving towards; the same as `getValue()` if the
+       * port isn't smoothed.
+       */
+      float getTargetValue()
+      {
+        return this->smoothingTarget ? *this->smoothingTarget : getValue();
+      }
+
+      /**
+       * @brief Called by the engine's ParamSmoother, which owns the target storage.
+       */
+      void bindSmoothingTarget(float *target)
+      {
+        *target = getValue();
+        this->smoothingTarget = target;
+      }
+
     private:
       CVInChangeListener *listener = NULL;
+      float smoothingTime = 0.f;
+      float *smoothingTarget = NULL;
     };
   }
 }
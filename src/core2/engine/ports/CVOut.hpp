@@ -1,12 +1,13 @@
 #pragma once
 
 #include "Port.hpp"
+#include "Channels.hpp"
 
 namespace phnq
 {
   namespace engine
   {
-    struct CVOut : Port<float>
+    struct CVOut : Port<float>, Channels<CVOut>
     {
       void setValue(float value) override
       {
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stddef.h>
+#include <algorithm>
+
+namespace phnq
+{
+  namespace engine
+  {
+    // Rack cables carry up to 16 channels.
+    const size_t MAX_CHANNELS = 16;
+
+    /**
+     * @brief Per-channel values for ports that can carry a polyphonic cable. A port
+     * only uses them once made polyphonic with `setPolyphonic()`; its regular value
+     * stays the mono signal for hosts without polyphonic cables (Seed, host).
+     *
+     * Channel values are 16-byte aligned and the array is always `MAX_CHANNELS`
+     * long, so they can be processed in groups of four (i.e. with
+     * `rack::simd::float_4::load()`) without a remainder. Engines writing them
+     * are responsible for clamping. Channel values are per-frame, so they are only
+     * moved by per-sample adapters such as Rack's.
+     *
+     * @tparam TPort the port type, returned by `setPolyphonic()` for chaining.
+     */
+    template <class TPort>
+    struct Channels
+    {
+    private:
+      alignas(16) float channelValues[MAX_CHANNELS] = {};
+      size_t numChannels = 1;
+      bool polyphonic = false;
+
+    public:
+      TPort *setPolyphonic(bool polyphonic)
+      {
+        this->polyphonic = polyphonic;
+        return static_cast<TPort *>(this);
+      }
+
+      bool isPolyphonic()
+      {
+        return this->polyphonic;
+      }
+
+      size_t getChannels()
+      {
+        return this->numChannels;
+      }
+
+      /**
+       * @brief Set the number of active channels, clamped to [1, MAX_CHANNELS].
+       */
+      void setChannels(size_t numChannels)
+      {
+        this->numChannels = std::min(std::max<size_t>(numChannels, 1), MAX_CHANNELS);
+      }
+
+      float *getChannelValues()
+      {
+        return this->channelValues;
+      }
+
+      void clearChannelValues()
+      {
+        std::fill(channelValues, channelValues + MAX_CHANNELS, 0.f);
+      }
+    };
+  }
+}
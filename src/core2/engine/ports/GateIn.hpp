@@ -6,7 +6,7 @@ namespace phnq
 {
   namespace engine
   {
-    struct GateIn : Port<bool>
+    struct GateIn : InputPort<bool>
     {
       enum Type
       {
@@ -19,18 +19,6 @@ namespace phnq
         virtual void gateValueDidChange(GateIn *port, bool value){};
       };
 
-      void setValue(bool value) override
-      {
-        if (value != getValue())
-        {
-          Port::setValue(value);
-          if (this->listener)
-          {
-            this->listener->gateValueDidChange(this, value);
-          }
-        }
-      }
-
       GateIn *setListener(GateChangeListener *listener)
       {
         this->listener = listener;
@@ -48,6 +36,19 @@ namespace phnq
         return type;
       }
 
+    protected:
+      void applyValue(bool value) override
+      {
+        if (value != getValue())
+        {
+          InputPort::applyValue(value);
+          if (this->listener)
+          {
+            this->listener->gateValueDidChange(this, value);
+          }
+        }
+      }
+
     private:
       GateChangeListener *listener = NULL;
       Type type = CV;
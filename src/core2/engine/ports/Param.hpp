@@ -19,13 +19,19 @@ namespace phnq
         return static_cast<Param *>(CVIn::setListener(listener));
       }
 
+      Param *setSmoothing(float seconds) override
+      {
+        return static_cast<Param *>(CVIn::setSmoothing(seconds));
+      }
+
       Param *setNumSteps(uint16_t numSteps)
       {
         this->numSteps = numSteps;
         return this;
       }
 
-      void setValue(float value) override
+    protected:
+      void applyValue(float value) override
       {
         if (numSteps > 1)
         {
@@ -33,9 +39,10 @@ namespace phnq
           value = interval * truncf(value / interval);
         }
 
-        CVIn::setValue(value);
+        CVIn::applyValue(value);
       }
 
+    public:
       uint16_t getStepValue()
       {
         if (numSteps < 2)
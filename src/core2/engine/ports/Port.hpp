@@ -1,6 +1,5 @@
 #pragma once
 
-#include <queue>
 #include <vector>
 #include <daisysp.h>
 #include "../Engine.hpp"
@@ -10,6 +9,18 @@ namespace phnq
   namespace engine
   {
     const float CV_CHANGE_THRESHOLD = 0.00001f;
+    const size_t PORT_EVENT_CAPACITY = 16;
+
+    /**
+     * @brief A value change scheduled at a frame offset from the start of the next
+     * block to be processed.
+     */
+    template <class T>
+    struct PortEvent
+    {
+      size_t frame;
+      T value;
+    };
 
     struct BasePort
     {
@@ -19,32 +30,71 @@ namespace phnq
     struct Port : BasePort
     {
     private:
+      // Hot: points into the owning engine's contiguous value storage once bound,
+      // otherwise at `ownValue`.
+      T *value = &ownValue;
+      T ownValue = T();
+
+      // Bumped whenever `setValue()` changes the value, so adapters can skip
+      // pushing values they have already sent.
+      uint32_t generation = 0;
+
+      // Cold: only touched at setup or when the value changes.
       std::string id;
-      T value;
-      uint16_t delay = 0;
-      std::queue<T> delayBuffer;
 
     public:
+      Port() {}
+      Port(const Port &) = delete;
+      Port &operator=(const Port &) = delete;
+
       T getValue()
       {
-        return this->value;
+        return *this->value;
+      }
+
+      /**
+       * @brief Move the port's value into external storage, such as a StaticEngine's
+       * PortValues. The current value is carried over.
+       *
+       * @param value storage for the port's value.
+       */
+      void bindValue(T *value)
+      {
+        *value = *this->value;
+        this->value = value;
       }
 
+      /**
+       * @brief Set the value immediately. Subclasses override this to clamp values
+       * and notify listeners.
+       */
       virtual void setValue(T value)
       {
-        // Queue up the value change if there is a delay set.
-        if (delay > 0)
+        if (*this->value != value)
         {
-          delayBuffer.push(value);
-          if (delayBuffer.size() < delay)
-          {
-            return;
-          }
-          value = delayBuffer.front();
-          delayBuffer.pop();
+          *this->value = value;
+          generation++;
         }
+      }
 
-        this->value = value;
+    protected:
+      /**
+       * @brief Signal a change that doesn't go through `setValue()`, such as a new
+       * smoothing target.
+       */
+      void bumpGeneration()
+      {
+        generation++;
+      }
+
+    public:
+      /**
+       * @brief A counter that changes whenever the value does. Comparing it with the
+       * generation last seen tells whether the value needs to be pushed again.
+       */
+      uint32_t getGeneration()
+      {
+        return this->generation;
       }
 
       std::string getId()
@@ -57,17 +107,147 @@ namespace phnq
         this->id = id;
         return this;
       }
+    };
+
+    /**
+     * @brief A port whose value comes from outside the engine, and so can be
+     * changed at an exact frame: `scheduleValue()` queues changes in a small
+     * fixed-capacity list, which the engine applies as it processes. Output ports
+     * are written by the engine itself and carry no such list.
+     *
+     * Subclasses clamp values and notify listeners in `applyValue()`, which is
+     * where every change, immediate or scheduled, lands.
+     */
+    template <class T>
+    struct InputPort : Port<T>
+    {
+    private:
+      // Scheduled value changes, sorted by frame.
+      PortEvent<T> events[PORT_EVENT_CAPACITY];
+      size_t numEvents = 0;
+      uint16_t delay = 0;
+
+    protected:
+      /**
+       * @brief Take on a value now.
+       */
+      virtual void applyValue(T value)
+      {
+        Port<T>::setValue(value);
+      }
+
+    public:
+      /**
+       * @brief Set the value, after the port's delay if it has one, or behind any
+       * pending changes (as a change scheduled at the start of the next block).
+       */
+      void setValue(T value) override
+      {
+        if (delay == 0 && numEvents == 0)
+        {
+          applyValue(value);
+        }
+        else
+        {
+          scheduleValue(value, 0);
+        }
+      }
+
+      /**
+       * @brief Schedule a value change for frame `frame` of the next block to be
+       * processed, plus the port's delay. Frames past the end of that block carry
+       * over into the following blocks. The engine applies the change at exactly
+       * that frame, so listeners fire there too. Call between blocks, not from
+       * inside `process()`/`processBlock()`.
+       *
+       * The change is always scheduled. If the port already has
+       * `PORT_EVENT_CAPACITY` pending changes, it takes the place of the last one,
+       * so the port still ends on the newest value rather than a stale one.
+       *
+       * @param value the new value.
+       * @param frame frame offset from the start of the next block.
+       * @return false if a pending change had to be replaced.
+       */
+      bool scheduleValue(T value, size_t frame)
+      {
+        frame += delay;
+
+        // Events almost always arrive in order, so this rarely moves anything.
+        bool isFull = numEvents == PORT_EVENT_CAPACITY;
+        size_t i = isFull ? numEvents - 1 : numEvents++;
+        for (; i > 0 && events[i - 1].frame > frame; i--)
+        {
+          events[i] = events[i - 1];
+        }
+        events[i] = {frame, value};
+        return !isFull;
+      }
+
+      /**
+       * @brief The value the port will have once all scheduled changes are applied.
+       */
+      T getScheduledValue()
+      {
+        return numEvents ? events[numEvents - 1].value : this->getValue();
+      }
+
+      bool hasEvents()
+      {
+        return numEvents > 0;
+      }
+
+      /**
+       * @brief Frame of the next scheduled change, relative to the current block.
+       * Only valid if `hasEvents()`.
+       */
+      size_t getNextEventFrame()
+      {
+        return events[0].frame;
+      }
+
+      /**
+       * @brief Apply the scheduled changes due at or before `frame` of the current block.
+       */
+      void applyEvents(size_t frame)
+      {
+        size_t numDue = 0;
+        while (numDue < numEvents && events[numDue].frame <= frame)
+        {
+          applyValue(events[numDue++].value);
+        }
+        if (numDue > 0)
+        {
+          for (size_t i = numDue; i < numEvents; i++)
+          {
+            events[i - numDue] = events[i];
+          }
+          numEvents -= numDue;
+        }
+      }
+
+      /**
+       * @brief Rebase pending changes on the start of the next block, once a block of
+       * `numFrames` frames has been processed.
+       */
+      void advanceEvents(size_t numFrames)
+      {
+        for (size_t i = 0; i < numEvents; i++)
+        {
+          events[i].frame = events[i].frame > numFrames ? events[i].frame - numFrames : 0;
+        }
+      }
 
       /**
-       * @brief Set the number frames before a set value takes effect. This can
-       * be useful when coordinating related input ports such as CV and Gate. The
-       * CV value change may lag a bit so delaying the gate allows the CV to
-       * settle before it's value is taken.
+       * @brief Set the number frames before a value set on the port takes effect,
+       * with `setValue()` or `scheduleValue()`. This can be useful when
+       * coordinating related input ports such as CV and Gate. The CV value change
+       * may lag a bit so delaying the gate allows the CV to settle before it's
+       * value is taken.
        *
        * @param delay number frames before a set value takes effect.
-       * @return Port* for chainability.
+       * @return InputPort* for chainability.
        */
-      auto setDelay(uint16_t delay) -> Port<T> *
+      auto setDelay(uint16_t delay) -> InputPort<T> *
       {
         this->delay = delay;
         return this;
@@ -0,0 +1,240 @@
+#pragma once
+
+/**
+ * Headless Host
+ * =============
+ * Shared pieces of the offline render harness used by `core2/host/HostModule.hpp`
+ * and the legacy `core/host/HostModule.hpp`. Nothing here depends on an engine
+ * implementation, the Rack SDK or libDaisy.
+ *
+ * Timeline Scripts
+ * ----------------
+ * Plain text, one event per line: `<time in seconds> <port id> <value>`. Blank
+ * lines and anything after a `#` are ignored. Events are applied at the exact
+ * frame they fall on, values hold until the next event for the same port.
+ *
+ *    # Record a two-note chord into PolyVox, then play it.
+ *    0.000 addChord    1
+ *    0.001 addChord    0
+ *    0.002 addNoteCV   0.3
+ *    0.003 addNoteGate 1
+ *    0.004 addNoteGate 0
+ *    0.005 addNoteCV   0.35
+ *    0.006 addNoteGate 1
+ *    0.007 addNoteGate 0
+ *    0.008 addChord    1
+ *    0.009 addChord    0
+ *    1.000 shape       0.8
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace phnq
+{
+  namespace host
+  {
+    enum OutputFormat
+    {
+      WAV, // 32-bit float WAV, one channel per output port.
+      RAW, // Interleaved native-endian 32-bit floats, no header.
+    };
+
+    struct Options
+    {
+      std::string scriptPath;
+      std::string outPath;
+      OutputFormat format = WAV;
+      float sampleRate = 48000.f;
+      size_t blockSize = 48;
+      float duration = 10.f;
+      size_t numThreads = 1;
+    };
+
+    struct TimelineEvent
+    {
+      uint64_t frame;
+      std::string portId;
+      float value;
+    };
+
+    static void printUsage(const char *name)
+    {
+      fprintf(stderr, "Usage: %s [-s script] [-o outfile] [-f wav|raw] [-r sampleRate] [-b blockSize] [-d seconds] [-j threads]\n", name);
+      fprintf(stderr, "  -s  timeline script (see src/core2/host/Host.hpp)\n");
+      fprintf(stderr, "  -o  write AudioOut and CVOut ports to this file\n");
+      fprintf(stderr, "  -f  output format, wav (32-bit float) or raw (interleaved float), default wav\n");
+      fprintf(stderr, "  -r  sample rate, default 48000\n");
+      fprintf(stderr, "  -b  block size in frames, default 48\n");
+      fprintf(stderr, "  -d  duration in seconds, default 10\n");
+      fprintf(stderr, "  -j  threads to run engine graph nodes on, default 1\n");
+    }
+
+    static bool parseOptions(int argc, char **argv, Options &options)
+    {
+      int opt;
+      while ((opt = getopt(argc, argv, "s:o:f:r:b:d:j:h")) != -1)
+      {
+        switch (opt)
+        {
+        case 's':
+          options.scriptPath = optarg;
+          break;
+        case 'o':
+          options.outPath = optarg;
+          break;
+        case 'f':
+          if (strcmp(optarg, "wav") == 0)
+          {
+            options.format = WAV;
+          }
+          else if (strcmp(optarg, "raw") == 0)
+          {
+            options.format = RAW;
+          }
+          else
+          {
+            fprintf(stderr, "Unknown output format: %s\n", optarg);
+            return false;
+          }
+          break;
+        case 'r':
+          options.sampleRate = strtof(optarg, NULL);
+          break;
+        case 'b':
+          options.blockSize = strtoul(optarg, NULL, 10);
+          break;
+        case 'd':
+          options.duration = strtof(optarg, NULL);
+          break;
+        case 'j':
+          options.numThreads = strtoul(optarg, NULL, 10);
+          break;
+        default:
+          printUsage(argv[0]);
+          return false;
+        }
+      }
+
+      if (options.sampleRate <= 0.f || options.blockSize == 0 || options.duration < 0.f || options.numThreads == 0)
+      {
+        printUsage(argv[0]);
+        return false;
+      }
+      return true;
+    }
+
+    static bool loadTimeline(std::string path, float sampleRate, std::vector<TimelineEvent> &timeline)
+    {
+      std::ifstream file(path.c_str());
+      if (!file)
+      {
+        fprintf(stderr, "Could not open timeline script: %s\n", path.c_str());
+        return false;
+      }
+
+      std::string line;
+      size_t lineNum = 0;
+      while (std::getline(file, line))
+      {
+        lineNum++;
+        line = line.substr(0, line.find('#'));
+
+        std::istringstream fields(line);
+        float time, value;
+        std::string portId;
+        if (!(fields >> time))
+        {
+          continue;
+        }
+        if (!(fields >> portId >> value) || time < 0.f)
+        {
+          fprintf(stderr, "%s:%lu: expected \"<seconds> <port id> <value>\"\n", path.c_str(), (unsigned long)lineNum);
+          return false;
+        }
+        timeline.push_back({(uint64_t)llroundf(time * sampleRate), portId, value});
+      }
+
+      std::stable_sort(timeline.begin(), timeline.end(), [](const TimelineEvent &a, const TimelineEvent &b)
+                       { return a.frame < b.frame; });
+      return true;
+    }
+
+    static void writeLE(FILE *file, uint32_t value, size_t numBytes)
+    {
+      for (size_t i = 0; i < numBytes; i++)
+      {
+        fputc((value >> (8 * i)) & 0xff, file);
+      }
+    }
+
+    /**
+     * @brief Write interleaved samples to a WAV or raw float file.
+     *
+     * @param samples interleaved frames of `numChannels` samples.
+     * @return true on success.
+     */
+    static bool writeOutput(const Options &options, size_t numChannels, const std::vector<float> &samples)
+    {
+      FILE *file = fopen(options.outPath.c_str(), "wb");
+      if (!file)
+      {
+        fprintf(stderr, "Could not open output file: %s\n", options.outPath.c_str());
+        return false;
+      }
+
+      if (options.format == WAV)
+      {
+        uint32_t dataSize = (uint32_t)(samples.size() * sizeof(float));
+        uint32_t sampleRate = (uint32_t)options.sampleRate;
+        fwrite("RIFF", 1, 4, file);
+        writeLE(file, 36 + dataSize, 4);
+        fwrite("WAVEfmt ", 1, 8, file);
+        writeLE(file, 16, 4);                                         // fmt chunk size
+        writeLE(file, 3, 2);                                          // WAVE_FORMAT_IEEE_FLOAT
+        writeLE(file, (uint32_t)numChannels, 2);                      // channels
+        writeLE(file, sampleRate, 4);                                 // sample rate
+        writeLE(file, sampleRate * numChannels * sizeof(float), 4);   // byte rate
+        writeLE(file, (uint32_t)(numChannels * sizeof(float)), 2);    // block align
+        writeLE(file, 32, 2);                                         // bits per sample
+        fwrite("data", 1, 4, file);
+        writeLE(file, dataSize, 4);
+      }
+
+      // Both the WAV data chunk and raw output are little-endian floats on the hosts we build for.
+      size_t written = fwrite(samples.data(), sizeof(float), samples.size(), file);
+      fclose(file);
+      return written == samples.size();
+    }
+
+    struct Stopwatch
+    {
+    private:
+      std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+    public:
+      double getElapsedNanos()
+      {
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - startTime).count();
+      }
+    };
+
+    static void reportTiming(uint64_t numFrames, float sampleRate, double elapsedNanos)
+    {
+      double renderedSeconds = numFrames / sampleRate;
+      double elapsedSeconds = elapsedNanos / 1e9;
+      printf("Rendered %llu frames (%.3f s @ %.0f Hz) in %.3f s\n", (unsigned long long)numFrames, renderedSeconds, sampleRate, elapsedSeconds);
+      printf("  ns/sample: %.1f\n", numFrames > 0 ? elapsedNanos / numFrames : 0.0);
+      printf("  real-time factor: %.1fx\n", elapsedSeconds > 0.0 ? renderedSeconds / elapsedSeconds : 0.0);
+    }
+  }
+}
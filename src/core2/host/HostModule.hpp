@@ -0,0 +1,241 @@
+#pragma once
+
+/**
+ * Host Adapter
+ * ============
+ * Renders `engineInstance` offline on the build machine. Input ports (AudioIn,
+ * CVIn, GateIn, Param/Button) are driven by id from a timeline script, and the
+ * AudioOut ports followed by the CVOut ports are written to the output file, one
+ * channel per port. Rendering goes through `doProcessBlock()`; timeline events are
+ * scheduled on their ports at their frame offset within the block, so each one
+ * lands on its exact frame.
+ *
+ * CV outs only hold a value, not a block, so when they are being written the
+ * engine is run one frame at a time to record them on every frame, like the
+ * audio. Timing is then of per-frame processing.
+ *
+ * Engines that are EngineGraphs can run their nodes on several threads with
+ * `-j`, which also reports per-node timing and the parallel speedup.
+ *
+ * Build and run:
+ *    TARGET=PolyVox make host
+ *    build/host/PolyVox -s timeline.txt -o out.wav -d 30
+ */
+
+#include <map>
+#include "../engine/Engine.hpp"
+#include "Host.hpp"
+#include "WorkStealingScheduler.hpp"
+
+extern phnq::engine::Engine *engineInstance;
+
+struct HostInput
+{
+  enum Type
+  {
+    AUDIO,
+    CV,
+    GATE,
+    PARAM,
+  };
+
+  Type type;
+  size_t index;
+};
+
+int main(int argc, char **argv)
+{
+  phnq::host::Options options;
+  if (!phnq::host::parseOptions(argc, argv, options))
+  {
+    return 1;
+  }
+
+  std::vector<phnq::host::TimelineEvent> timeline;
+  if (!options.scriptPath.empty() && !phnq::host::loadTimeline(options.scriptPath, options.sampleRate, timeline))
+  {
+    return 1;
+  }
+
+  phnq::engine::Engine *engine = engineInstance;
+  phnq::engine::FrameInfo frameInfo = {options.sampleRate, 1.f / options.sampleRate};
+
+  std::unique_ptr<phnq::host::WorkStealingScheduler> scheduler;
+  if (options.numThreads > 1)
+  {
+    phnq::engine::SchedulableGraph *graph = dynamic_cast<phnq::engine::SchedulableGraph *>(engine);
+    if (graph)
+    {
+      scheduler.reset(new phnq::host::WorkStealingScheduler(options.numThreads));
+      graph->setScheduler(scheduler.get());
+    }
+    else
+    {
+      fprintf(stderr, "Not an engine graph, rendering on one thread\n");
+    }
+  }
+
+  phnq::engine::PortView<phnq::engine::AudioIn> audioIns = engine->getAudioIns();
+  phnq::engine::PortView<phnq::engine::AudioOut> audioOuts = engine->getAudioOuts();
+  phnq::engine::PortView<phnq::engine::CVIn> cvIns = engine->getCVIns();
+  phnq::engine::PortView<phnq::engine::CVOut> cvOuts = engine->getCVOuts();
+  phnq::engine::PortView<phnq::engine::GateIn> gateIns = engine->getGateIns();
+  phnq::engine::PortView<phnq::engine::Param> params = engine->getParams();
+
+  std::map<std::string, HostInput> inputsById;
+  for (size_t i = 0; i < audioIns.size(); i++)
+  {
+    inputsById[audioIns[i]->getId()] = {HostInput::AUDIO, i};
+  }
+  for (size_t i = 0; i < cvIns.size(); i++)
+  {
+    inputsById[cvIns[i]->getId()] = {HostInput::CV, i};
+  }
+  for (size_t i = 0; i < gateIns.size(); i++)
+  {
+    inputsById[gateIns[i]->getId()] = {HostInput::GATE, i};
+  }
+  for (size_t i = 0; i < params.size(); i++)
+  {
+    inputsById[params[i]->getId()] = {HostInput::PARAM, i};
+  }
+
+  // Resolve port ids up front so the render loop does no lookups.
+  std::vector<HostInput> eventInputs;
+  for (const phnq::host::TimelineEvent &event : timeline)
+  {
+    std::map<std::string, HostInput>::iterator it = inputsById.find(event.portId);
+    if (it == inputsById.end())
+    {
+      fprintf(stderr, "No input port with id \"%s\"\n", event.portId.c_str());
+      return 1;
+    }
+    eventInputs.push_back(it->second);
+  }
+
+  size_t blockSize = options.blockSize;
+  std::vector<float> audioInValues(audioIns.size(), 0.f);
+  std::vector<std::vector<float>> audioInBlocks(audioIns.size(), std::vector<float>(blockSize));
+  std::vector<std::vector<float>> audioOutBlocks(audioOuts.size(), std::vector<float>(blockSize));
+  std::vector<std::vector<float>> cvOutBlocks(cvOuts.size(), std::vector<float>(blockSize));
+  std::vector<const float *> audioInBlockPtrs;
+  std::vector<float *> audioOutBlockPtrs;
+  for (std::vector<float> &block : audioInBlocks)
+  {
+    audioInBlockPtrs.push_back(block.data());
+  }
+  for (std::vector<float> &block : audioOutBlocks)
+  {
+    audioOutBlockPtrs.push_back(block.data());
+  }
+
+  uint64_t numFrames = (uint64_t)(options.duration * options.sampleRate);
+  size_t numChannels = audioOuts.size() + cvOuts.size();
+  std::vector<float> output(options.outPath.empty() ? 0 : numFrames * numChannels);
+  bool recordsCVPerFrame = !output.empty() && cvOuts.size() > 0;
+  std::vector<const float *> frameInPtrs(audioIns.size());
+  std::vector<float *> frameOutPtrs(audioOuts.size());
+
+  phnq::host::Stopwatch stopwatch;
+
+  size_t eventIndex = 0;
+  uint64_t frame = 0;
+  while (frame < numFrames)
+  {
+    size_t numBlockFrames = (size_t)std::min<uint64_t>(blockSize, numFrames - frame);
+
+    for (size_t i = 0; i < audioIns.size(); i++)
+    {
+      std::fill(audioInBlocks[i].begin(), audioInBlocks[i].begin() + numBlockFrames, audioInValues[i]);
+    }
+
+    // Schedule this block's events at their frame offsets; the engine applies them
+    // at exactly those frames.
+    for (; eventIndex < timeline.size() && timeline[eventIndex].frame < frame + numBlockFrames; eventIndex++)
+    {
+      HostInput input = eventInputs[eventIndex];
+      float value = timeline[eventIndex].value;
+      size_t offset = (size_t)(std::max(timeline[eventIndex].frame, frame) - frame);
+      bool scheduled = true;
+      switch (input.type)
+      {
+      case HostInput::AUDIO:
+        audioInValues[input.index] = value;
+        std::fill(audioInBlocks[input.index].begin() + offset, audioInBlocks[input.index].begin() + numBlockFrames, value);
+        break;
+      case HostInput::CV:
+        scheduled = cvIns[input.index]->scheduleValue(value, offset);
+        break;
+      case HostInput::GATE:
+        scheduled = gateIns[input.index]->scheduleValue(value > 0.5f, offset);
+        break;
+      case HostInput::PARAM:
+        scheduled = params[input.index]->scheduleValue(value, offset);
+        break;
+      }
+      if (!scheduled)
+      {
+        fprintf(stderr, "Too many events for \"%s\" in one block, the one at frame %llu replaced the one before\n",
+                timeline[eventIndex].portId.c_str(), (unsigned long long)timeline[eventIndex].frame);
+      }
+    }
+
+    if (recordsCVPerFrame)
+    {
+      // Blocks of one frame; events scheduled for later frames carry over.
+      for (size_t blockFrame = 0; blockFrame < numBlockFrames; blockFrame++)
+      {
+        for (size_t i = 0; i < audioIns.size(); i++)
+        {
+          frameInPtrs[i] = audioInBlockPtrs[i] + blockFrame;
+        }
+        for (size_t i = 0; i < audioOuts.size(); i++)
+        {
+          frameOutPtrs[i] = audioOutBlockPtrs[i] + blockFrame;
+        }
+        engine->doProcessBlock(frameInfo, 1, frameInPtrs.data(), frameOutPtrs.data());
+        for (size_t i = 0; i < cvOuts.size(); i++)
+        {
+          cvOutBlocks[i][blockFrame] = cvOuts[i]->getValue();
+        }
+      }
+    }
+    else
+    {
+      engine->doProcessBlock(frameInfo, numBlockFrames, audioInBlockPtrs.data(), audioOutBlockPtrs.data());
+    }
+
+    if (!output.empty())
+    {
+      float *out = &output[frame * numChannels];
+      for (size_t blockFrame = 0; blockFrame < numBlockFrames; blockFrame++, out += numChannels)
+      {
+        for (size_t i = 0; i < audioOuts.size(); i++)
+        {
+          out[i] = audioOutBlocks[i][blockFrame];
+        }
+        for (size_t i = 0; i < cvOuts.size(); i++)
+        {
+          out[audioOuts.size() + i] = cvOutBlocks[i][blockFrame];
+        }
+      }
+    }
+
+    frame += numBlockFrames;
+  }
+
+  phnq::host::reportTiming(numFrames, options.sampleRate, stopwatch.getElapsedNanos());
+
+  phnq::engine::SleepStats sleepStats = engine->getSleepStats();
+  printf("  asleep: %.1f%% (%u sleeps)\n", sleepStats.numFrames ? 100.0 * sleepStats.numAsleepFrames / sleepStats.numFrames : 0.0, sleepStats.numSleeps);
+  if (scheduler)
+  {
+    scheduler->report(numFrames);
+  }
+
+  if (!options.outPath.empty() && !phnq::host::writeOutput(options, numChannels, output))
+  {
+    return 1;
+  }
+  return 0;
+}
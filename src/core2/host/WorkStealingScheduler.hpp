@@ -0,0 +1,299 @@
+#pragma once
+
+/**
+ * Work-Stealing Scheduler
+ * =======================
+ * Runs an EngineGraph's nodes on several cores of the build machine. Each block,
+ * nodes with no pending dependencies are queued on per-thread deques. A thread
+ * runs its own newest node first (keeping a branch on one core), and steals the
+ * oldest node from another thread's deque when it runs out. Finishing a node
+ * queues the dependents it was the last to wait for, so dependent nodes are
+ * synchronized per block while independent branches run in parallel.
+ *
+ * The thread calling `runNodes()` (the render loop) works too, so `numThreads`
+ * counts it. Helper threads wait on a condition variable between blocks and
+ * spin (yielding) within one. Every helper takes part in every block, even one
+ * woken after all nodes have run, and `runNodes()` doesn't return until each has
+ * finished with the block, so no helper can carry a steal over into the next.
+ *
+ * Host only: this uses std::thread, so link with -pthread.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "../engine/EngineGraph.hpp"
+
+namespace phnq
+{
+  namespace host
+  {
+    /**
+     * @brief Time spent in one node, summed over all blocks.
+     */
+    struct NodeTiming
+    {
+      uint64_t numRuns;
+      double totalNanos;
+    };
+
+    struct WorkStealingScheduler : engine::NodeScheduler
+    {
+    private:
+      /**
+       * @brief Nodes ready to run, in a ring with room for every node of the graph,
+       * so queueing never allocates. The owner takes from the back, thieves from
+       * the front.
+       */
+      struct Worker
+      {
+        std::mutex mutex;
+        std::vector<size_t> nodes;
+        size_t first = 0;
+        size_t count = 0;
+      };
+
+      std::vector<std::unique_ptr<Worker>> workers; // Worker 0 is the calling thread.
+      std::vector<std::thread> threads;
+
+      std::vector<std::vector<size_t>> dependents;
+      std::vector<size_t> numDependencies;
+      std::unique_ptr<std::atomic<size_t>[]> numPending; // Per node, dependencies left this block.
+      std::atomic<size_t> numNodesDone;
+      std::atomic<size_t> numHelpersDone; // Helpers finished with the current block.
+      engine::NodeRunner *runner = NULL;
+
+      std::mutex blockMutex;
+      std::condition_variable blockStarted;
+      uint64_t blockNumber = 0; // Guarded by blockMutex, as are the block's counters and roots while it starts.
+      bool isStopping = false;
+
+      std::vector<NodeTiming> nodeTimings;
+      double totalNanos = 0.0; // Wall time spent in `runNodes()`.
+
+    public:
+      /**
+       * @param numThreads threads to run nodes on, including the calling thread.
+       */
+      WorkStealingScheduler(size_t numThreads) : numNodesDone(0), numHelpersDone(0)
+      {
+        for (size_t i = 0; i < std::max<size_t>(numThreads, 1); i++)
+        {
+          workers.push_back(std::unique_ptr<Worker>(new Worker()));
+        }
+        for (size_t i = 1; i < workers.size(); i++)
+        {
+          threads.push_back(std::thread(&WorkStealingScheduler::runHelper, this, i));
+        }
+      }
+
+      ~WorkStealingScheduler()
+      {
+        {
+          std::lock_guard<std::mutex> lock(blockMutex);
+          isStopping = true;
+        }
+        blockStarted.notify_all();
+        for (std::thread &thread : threads)
+        {
+          thread.join();
+        }
+      }
+
+      void setDependencies(const std::vector<std::vector<size_t>> &dependents) override
+      {
+        size_t numNodes = dependents.size();
+        this->dependents = dependents;
+        numDependencies.assign(numNodes, 0);
+        for (const std::vector<size_t> &targets : dependents)
+        {
+          for (size_t target : targets)
+          {
+            numDependencies[target]++;
+          }
+        }
+        numPending.reset(new std::atomic<size_t>[numNodes]);
+        for (std::unique_ptr<Worker> &worker : workers)
+        {
+          worker->nodes.assign(numNodes, 0);
+          worker->first = 0;
+          worker->count = 0;
+        }
+        nodeTimings.assign(numNodes, {0, 0.0});
+        totalNanos = 0.0;
+      }
+
+      void runNodes(engine::NodeRunner &runner) override
+      {
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+        // Every helper has finished with the previous block, so nothing else
+        // touches the counters or deques until the new block number is published.
+        {
+          std::lock_guard<std::mutex> lock(blockMutex);
+          this->runner = &runner;
+          numNodesDone.store(0, std::memory_order_relaxed);
+          numHelpersDone.store(0, std::memory_order_relaxed);
+          size_t numRoots = 0;
+          for (size_t i = 0; i < dependents.size(); i++)
+          {
+            numPending[i].store(numDependencies[i], std::memory_order_relaxed);
+            if (numDependencies[i] == 0)
+            {
+              pushNode(numRoots++ % workers.size(), i);
+            }
+          }
+          blockNumber++;
+        }
+        blockStarted.notify_all();
+
+        runWorker(0);
+
+        size_t numHelpers = workers.size() - 1;
+        while (numHelpersDone.load(std::memory_order_acquire) < numHelpers)
+        {
+          std::this_thread::yield();
+        }
+
+        totalNanos += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - startTime).count();
+      }
+
+      const std::vector<NodeTiming> &getNodeTimings()
+      {
+        return nodeTimings;
+      }
+
+      /**
+       * @brief Time spent in nodes divided by wall time, i.e. how many cores were
+       * busy on average. 1.0 means no gain over running nodes in order.
+       */
+      double getSpeedup()
+      {
+        double nodeNanos = 0.0;
+        for (NodeTiming &timing : nodeTimings)
+        {
+          nodeNanos += timing.totalNanos;
+        }
+        return totalNanos > 0.0 ? nodeNanos / totalNanos : 0.0;
+      }
+
+      void report(uint64_t numFrames)
+      {
+        printf("  threads: %lu, parallel speedup: %.2fx\n", (unsigned long)workers.size(), getSpeedup());
+        for (size_t i = 0; i < nodeTimings.size(); i++)
+        {
+          printf("    node %lu: %.1f ns/sample, %.1f us/run\n", (unsigned long)i,
+                 numFrames ? nodeTimings[i].totalNanos / numFrames : 0.0,
+                 nodeTimings[i].numRuns ? nodeTimings[i].totalNanos / nodeTimings[i].numRuns / 1e3 : 0.0);
+        }
+      }
+
+    private:
+      void runHelper(size_t index)
+      {
+        uint64_t seenBlockNumber = 0;
+        while (true)
+        {
+          {
+            std::unique_lock<std::mutex> lock(blockMutex);
+            blockStarted.wait(lock, [&]()
+                              { return isStopping || blockNumber != seenBlockNumber; });
+            if (isStopping)
+            {
+              return;
+            }
+            // `runNodes()` waits for this helper before starting another block, so
+            // this is the block after the last one it ran.
+            seenBlockNumber = blockNumber;
+          }
+
+          runWorker(index);
+          numHelpersDone.fetch_add(1, std::memory_order_acq_rel);
+        }
+      }
+
+      /**
+       * @brief Run and steal nodes until every node of the block has finished.
+       */
+      void runWorker(size_t index)
+      {
+        size_t numNodes = dependents.size();
+        while (numNodesDone.load(std::memory_order_acquire) < numNodes)
+        {
+          size_t node;
+          if (popNode(index, node) || stealNode(index, node))
+          {
+            runNode(index, node);
+          }
+          else
+          {
+            std::this_thread::yield();
+          }
+        }
+      }
+
+      void runNode(size_t index, size_t node)
+      {
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        runner->runNode(node);
+        nodeTimings[node].numRuns++;
+        nodeTimings[node].totalNanos += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - startTime).count();
+
+        // Queue dependents before counting this node as done, so the block can't
+        // look finished while they are still to run.
+        for (size_t target : dependents[node])
+        {
+          if (numPending[target].fetch_sub(1, std::memory_order_acq_rel) == 1)
+          {
+            pushNode(index, target);
+          }
+        }
+        numNodesDone.fetch_add(1, std::memory_order_acq_rel);
+      }
+
+      void pushNode(size_t index, size_t node)
+      {
+        Worker &worker = *workers[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.nodes[(worker.first + worker.count) % worker.nodes.size()] = node;
+        worker.count++;
+      }
+
+      bool popNode(size_t index, size_t &node)
+      {
+        Worker &worker = *workers[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (worker.count == 0)
+        {
+          return false;
+        }
+        worker.count--;
+        node = worker.nodes[(worker.first + worker.count) % worker.nodes.size()];
+        return true;
+      }
+
+      bool stealNode(size_t index, size_t &node)
+      {
+        for (size_t i = 1; i < workers.size(); i++)
+        {
+          Worker &victim = *workers[(index + i) % workers.size()];
+          std::lock_guard<std::mutex> lock(victim.mutex);
+          if (victim.count > 0)
+          {
+            node = victim.nodes[victim.first];
+            victim.first = (victim.first + 1) % victim.nodes.size();
+            victim.count--;
+            return true;
+          }
+        }
+        return false;
+      }
+    };
+  }
+}
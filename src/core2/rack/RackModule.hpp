@@ -1,90 +1,217 @@
 #pragma once
 
 #include <rack.hpp>
-#include "../engine/Engine.hpp"
+#include "../engine/StaticEngine.hpp"
 
 namespace phnq
 {
   namespace vcv
   {
+    const uint32_t LIGHT_UPDATE_DIVIDER = 64;
+
     std::map<engine::BasePort *, u_int8_t> getPortIndexes(engine::Engine *engine);
 
+    /**
+     * @brief Rack adapter for a StaticEngine. Host indexes come from the engine's
+     * PortSchema at compile time, so processing is a straight pass over fixed-size
+     * arrays. Inputs go through the ports so listeners fire; outputs are drained
+     * straight from the engine's PortValues. Params, CV ins, CV outs, gate outs and
+     * lights are only pushed when they change, and lights are only checked every
+     * `LIGHT_UPDATE_DIVIDER` frames. Polyphonic audio and CV ports move all of
+     * their cable's channels.
+     */
     template <class TEngine>
     struct RackModule : rack::engine::Module
     {
+      typedef typename TEngine::Schema Schema;
+
     private:
-      engine::Engine *engine = new TEngine();
-      std::map<engine::BasePort *, u_int8_t> portIndexes;
+      TEngine *engine = new TEngine();
+
+      // Last values pushed to the engine, and generations of the last values
+      // pushed to Rack, so unchanged values can be skipped.
+      std::array<float, Schema::NUM_ALL_PARAMS> paramValues;
+      std::array<float, Schema::NUM_CV_INS> cvInVoltages;
+      std::array<uint32_t, Schema::NUM_CV_OUTS> cvOutGenerations;
+      std::array<uint32_t, Schema::NUM_GATE_OUTS> gateOutGenerations;
+      std::array<uint32_t, Schema::NUM_LIGHTS> lightGenerations;
+
+      rack::dsp::ClockDivider lightDivider;
 
     public:
       RackModule()
       {
-        portIndexes = getPortIndexes(engine);
-        config(engine->getParams().size(),
-               engine->getAudioIns().size() + engine->getCVIns().size() + engine->getGateIns().size(),
-               engine->getAudioOuts().size() + engine->getCVOuts().size() + engine->getGateOuts().size(),
-               engine->getLights().size());
+        engine->checkSchemaComplete();
+        config(Schema::NUM_ALL_PARAMS, Schema::NUM_INPUTS, Schema::NUM_OUTPUTS, Schema::NUM_LIGHTS);
+
+        // Ensure everything is pushed on the first frame.
+        paramValues.fill(NAN);
+        cvInVoltages.fill(NAN);
+        cvOutGenerations.fill(UINT32_MAX);
+        gateOutGenerations.fill(UINT32_MAX);
+        lightGenerations.fill(UINT32_MAX);
+
+        lightDivider.setDivision(LIGHT_UPDATE_DIVIDER);
+      }
+
+      ~RackModule()
+      {
+        engine::SleepStats stats = engine->getSleepStats();
+        PHNQ_LOG("Engine was asleep for %llu of %llu frames (%u sleeps)",
+                 (unsigned long long)stats.numAsleepFrames, (unsigned long long)stats.numFrames, stats.numSleeps);
+        delete engine;
       }
 
       TEngine *getEngine()
       {
-        return static_cast<TEngine *>(this->engine);
+        return this->engine;
+      }
+
+      /**
+       * @brief Copy all channels of a polyphonic cable into a port, four at a time.
+       * Rack ports and engine ports both hold `MAX_CHANNELS` values, so the last
+       * group never reads or writes out of bounds.
+       */
+      template <class TPort>
+      static void readChannels(rack::engine::Input &input, TPort &port, float scale)
+      {
+        port.setChannels(input.getChannels());
+        float *channelValues = port.getChannelValues();
+        for (size_t channel = 0; channel < port.getChannels(); channel += 4)
+        {
+          (rack::simd::float_4::load(input.getVoltages(channel)) * scale).store(&channelValues[channel]);
+        }
+      }
+
+      template <class TPort>
+      static void writeChannels(TPort &port, rack::engine::Output &output, float scale)
+      {
+        output.setChannels(port.getChannels());
+        float *channelValues = port.getChannelValues();
+        for (size_t channel = 0; channel < port.getChannels(); channel += 4)
+        {
+          (rack::simd::float_4::load(&channelValues[channel]) * scale).store(output.getVoltages(channel));
+        }
       }
 
       void process(const ProcessArgs &args) override
       {
-        for (engine::Param *param : engine->getParams())
+        engine::PortStorage<Schema> &ports = engine->getPortStorage();
+        engine::PortValues<Schema> &values = engine->getPortValues();
+
+        for (size_t i = 0; i < Schema::NUM_ALL_PARAMS; i++)
         {
-          param->setValue(params[portIndexes[param]].getValue());
+          float value = params[i].getValue();
+          if (value != paramValues[i])
+          {
+            paramValues[i] = value;
+            ports.params[i]->setValue(value);
+          }
         }
 
-        for (engine::AudioIn *audioIn : engine->getAudioIns())
+        for (size_t i = 0; i < Schema::NUM_AUDIO_INS; i++)
         {
-          audioIn->setValue(inputs[portIndexes[audioIn]].getVoltage() / 5.f);
+          rack::engine::Input &input = inputs[Schema::AUDIO_IN_OFFSET + i];
+          if (ports.audioIns[i].isPolyphonic())
+          {
+            readChannels(input, ports.audioIns[i], 1.f / 5.f);
+          }
+          ports.audioIns[i].setValue(input.getVoltage() / 5.f);
         }
 
-        for (engine::CVIn *cvIn : engine->getCVIns())
+        for (size_t i = 0; i < Schema::NUM_CV_INS; i++)
         {
-          cvIn->setValue(inputs[portIndexes[cvIn]].getVoltage() / 10.f);
+          if (ports.cvIns[i].isPolyphonic())
+          {
+            readChannels(inputs[Schema::CV_IN_OFFSET + i], ports.cvIns[i], 1.f / 10.f);
+          }
+
+          float voltage = inputs[Schema::CV_IN_OFFSET + i].getVoltage();
+          if (voltage != cvInVoltages[i])
+          {
+            cvInVoltages[i] = voltage;
+            ports.cvIns[i].setValue(voltage / 10.f);
+          }
         }
 
-        for (engine::GateIn *gateIn : engine->getGateIns())
+        for (size_t i = 0; i < Schema::NUM_GATE_INS; i++)
         {
           /**
            * @brief Avoid rapid gate flipping as per:
            *    https://vcvrack.com/manual/VoltageStandards#Triggers-and-Gates
+           *
+           * Gates are scheduled rather than set so a port's delay applies.
            */
-          float voltage = inputs[portIndexes[gateIn]].getVoltage();
-          if (gateIn->getValue() && voltage < 2.f)
+          engine::GateIn &gateIn = ports.gateIns[i];
+          bool gate = gateIn.getScheduledValue();
+          float voltage = inputs[Schema::GATE_IN_OFFSET + i].getVoltage();
+          if (gate && voltage < 2.f)
           {
-            gateIn->setValue(false);
+            gateIn.scheduleValue(false, 0);
           }
-          else if (!gateIn->getValue() && voltage > 0.1f)
+          else if (!gate && voltage > 0.1f)
           {
-            gateIn->setValue(true);
+            gateIn.scheduleValue(true, 0);
           }
         }
 
+        bool areOutputsConnected = false;
+        for (size_t i = 0; i < Schema::NUM_OUTPUTS; i++)
+        {
+          areOutputsConnected |= outputs[i].isConnected();
+        }
+        engine->setOutputsConnected(areOutputsConnected);
+
         engine->doProcess({args.sampleRate, args.sampleTime});
 
-        for (engine::AudioOut *audioOut : engine->getAudioOuts())
+        for (size_t i = 0; i < Schema::NUM_AUDIO_OUTS; i++)
         {
-          outputs[portIndexes[audioOut]].setVoltage(audioOut->getValue() * 5.f);
+          if (ports.audioOuts[i].isPolyphonic())
+          {
+            writeChannels(ports.audioOuts[i], outputs[Schema::AUDIO_OUT_OFFSET + i], 5.f);
+          }
+          else
+          {
+            outputs[Schema::AUDIO_OUT_OFFSET + i].setVoltage(values.audioOuts[i] * 5.f);
+          }
         }
 
-        for (engine::CVOut *cvOut : engine->getCVOuts())
+        for (size_t i = 0; i < Schema::NUM_CV_OUTS; i++)
         {
-          outputs[portIndexes[cvOut]].setVoltage(cvOut->getValue() * 10.f);
+          uint32_t generation = ports.cvOuts[i].getGeneration();
+          if (ports.cvOuts[i].isPolyphonic())
+          {
+            writeChannels(ports.cvOuts[i], outputs[Schema::CV_OUT_OFFSET + i], 10.f);
+          }
+          else if (generation != cvOutGenerations[i])
+          {
+            cvOutGenerations[i] = generation;
+            outputs[Schema::CV_OUT_OFFSET + i].setVoltage(values.cvOuts[i] * 10.f);
+          }
         }
 
-        for (engine::GateOut *gateOut : engine->getGateOuts())
+        for (size_t i = 0; i < Schema::NUM_GATE_OUTS; i++)
         {
-          outputs[portIndexes[gateOut]].setVoltage(gateOut->getValue() ? 10.f : 0.f);
+          uint32_t generation = ports.gateOuts[i].getGeneration();
+          if (generation != gateOutGenerations[i])
+          {
+            gateOutGenerations[i] = generation;
+            outputs[Schema::GATE_OUT_OFFSET + i].setVoltage(values.gateOuts[i] ? 10.f : 0.f);
+          }
         }
 
-        for (engine::Light *light : engine->getLights())
+        // Lights only need to keep up with the screen.
+        if (lightDivider.process())
         {
-          lights[portIndexes[light]].setBrightness(light->getValue());
+          for (size_t i = 0; i < Schema::NUM_LIGHTS; i++)
+          {
+            uint32_t generation = ports.lights[i].getGeneration();
+            if (generation != lightGenerations[i])
+            {
+              lightGenerations[i] = generation;
+              lights[i].setBrightness(values.lights[i]);
+            }
+          }
         }
       }
     };
@@ -43,13 +43,18 @@
 
 #include "daisysp.h"
 #include "daisy_seed.h"
-#include "../engine/Engine.hpp"
+#include "../engine/StaticEngine.hpp"
+#include "../engine/AdcDeadband.hpp"
 
 extern phnq::engine::Engine *engineInstance;
 
 using namespace daisy;
 using namespace daisy::seed;
 
+const size_t AUDIO_BLOCK_SIZE = 4;
+const size_t NUM_AUDIO_CHANNELS = 2;
+const uint32_t SLEEP_STATS_LOG_INTERVAL_MS = 10000;
+
 const DacHandle::Channel DAC_CHANNELS[] = {DacHandle::Channel::ONE, DacHandle::Channel::TWO};
 
 struct AdcChannel
@@ -66,6 +71,30 @@ struct GPIOChannel
 };
 const GPIOChannel GPIO_CHANNELS[] = {{1, D1}, {2, D2}, {3, D3}, {4, D4}, {5, D5}, {6, D6}, {7, D7}, {8, D8}, {9, D9}, {10, D10}, {11, D11}, {12, D12}, {13, D13}, {14, D14}, {29, D29}, {30, D30}};
 
+const size_t NUM_ADC_CHANNELS = sizeof(ADC_CHANNELS) / sizeof(ADC_CHANNELS[0]);
+const size_t NUM_GPIO_CHANNELS = sizeof(GPIO_CHANNELS) / sizeof(GPIO_CHANNELS[0]);
+const size_t NUM_DAC_CHANNELS = sizeof(DAC_CHANNELS) / sizeof(DAC_CHANNELS[0]);
+
+/**
+ * @brief Instantiate the module's engine, rejecting port schemas that don't fit
+ * on the Seed at compile time.
+ */
+template <class TEngine>
+phnq::engine::Engine *createSeedEngine()
+{
+  typedef typename TEngine::Schema Schema;
+  static_assert(Schema::NUM_AUDIO_INS <= NUM_AUDIO_CHANNELS, "Too many audio ins for the Seed");
+  static_assert(Schema::NUM_AUDIO_OUTS <= NUM_AUDIO_CHANNELS, "Too many audio outs for the Seed");
+  static_assert(Schema::NUM_CV_INS + Schema::NUM_PARAMS <= NUM_ADC_CHANNELS, "Too many CV ins + params for the Seed's ADC channels");
+  static_assert(Schema::NUM_CV_OUTS <= NUM_DAC_CHANNELS, "Too many CV outs for the Seed's DAC channels");
+  static_assert(Schema::NUM_BUTTONS + Schema::NUM_GATE_INS + Schema::NUM_GATE_OUTS + Schema::NUM_LIGHTS <= NUM_GPIO_CHANNELS,
+                "Too many buttons + gate ins + gate outs + lights for the Seed's GPIO pins");
+
+  TEngine *engine = new TEngine();
+  engine->checkSchemaComplete();
+  return engine;
+}
+
 template <class T>
 struct AudioMapping
 {
@@ -77,6 +106,7 @@ struct DACMapping
 {
   DacHandle::Channel channel;
   phnq::engine::CVOut *port;
+  uint32_t sentGeneration; // Port generation last written to the DAC.
 };
 
 template <class T>
@@ -84,6 +114,7 @@ struct ADCMapping
 {
   AdcChannel channel;
   T *port;
+  float postedValue; // Last reading posted to the engine, in [0, 1], NAN until the first post.
 };
 
 template <class T>
@@ -92,6 +123,8 @@ struct GPIOMapping
   GPIO *gpio = new GPIO();
   GPIOChannel channel;
   T *port;
+  bool postedValue = false;            // Inputs: last value posted to the engine.
+  uint32_t sentGeneration = UINT32_MAX; // Outputs: port generation last written to the pin.
 };
 
 struct LedMapping
@@ -99,12 +132,12 @@ struct LedMapping
   Led *led = new Led();
   GPIOChannel channel;
   phnq::engine::Port<float> *port;
+  uint32_t sentGeneration = UINT32_MAX; // Port generation last set on the LED.
 };
 
 DaisySeed hw;
 DacHandle::Config cfg;
 AdcChannelConfig *adcConfig;
-phnq::engine::Engine *engine = engineInstance;
 phnq::engine::FrameInfo frameInfo;
 std::vector<AudioMapping<phnq::engine::AudioIn>> audioInMappings;
 std::vector<AudioMapping<phnq::engine::AudioOut>> audioOutMappings;
@@ -120,7 +153,7 @@ void initializeHardware()
 {
   hw.Configure();
   hw.Init();
-  hw.SetAudioBlockSize(4);
+  hw.SetAudioBlockSize(AUDIO_BLOCK_SIZE);
   hw.StartLog(true);
 
   frameInfo.sampleRate = hw.AudioSampleRate();
@@ -130,47 +163,47 @@ void initializeHardware()
 void setupPinMappings()
 {
   PHNQ_LOG("Pin:Port mappings:");
-  for (auto *audioIn : engine->getAudioIns())
+  for (auto *audioIn : engineInstance->getAudioIns())
   {
     AudioMapping<phnq::engine::AudioIn> mapping = {audioInMappings.size(), audioIn};
     audioInMappings.push_back(mapping);
     PHNQ_LOG("  [Audio In %d] \"%s\"", mapping.index + 1, mapping.port->getId().c_str());
   }
 
-  for (auto *audioOut : engine->getAudioOuts())
+  for (auto *audioOut : engineInstance->getAudioOuts())
   {
     AudioMapping<phnq::engine::AudioOut> mapping = {audioOutMappings.size(), audioOut};
     audioOutMappings.push_back(mapping);
     PHNQ_LOG("  [Audio Out %d] \"%s\"", mapping.index + 1, mapping.port->getId().c_str());
   }
 
-  for (auto *cvIn : engine->getCVIns())
+  for (auto *cvIn : engineInstance->getCVIns())
   {
-    ADCMapping<phnq::engine::CVIn> mapping = {ADC_CHANNELS[cvInMappings.size() + paramMappings.size()], cvIn};
+    ADCMapping<phnq::engine::CVIn> mapping = {ADC_CHANNELS[cvInMappings.size() + paramMappings.size()], cvIn, NAN};
     cvInMappings.push_back(mapping);
     PHNQ_LOG("  [ADC %d] CV In \"%s\"", mapping.channel.index, mapping.port->getId().c_str());
   }
 
-  for (auto *param : engine->getParams())
+  for (auto *param : engineInstance->getParams())
   {
     if (param->getType() != phnq::engine::Param::BUTTON)
     {
-      ADCMapping<phnq::engine::Param> mapping = {ADC_CHANNELS[cvInMappings.size() + paramMappings.size()], param};
+      ADCMapping<phnq::engine::Param> mapping = {ADC_CHANNELS[cvInMappings.size() + paramMappings.size()], param, NAN};
       paramMappings.push_back(mapping);
       PHNQ_LOG("  [ADC %d] Param \"%s\"", mapping.channel.index, mapping.port->getId().c_str());
     }
   }
 
-  for (auto *cvOut : engine->getCVOuts())
+  for (auto *cvOut : engineInstance->getCVOuts())
   {
-    DACMapping mapping = {DAC_CHANNELS[dacMappings.size()], cvOut};
+    DACMapping mapping = {DAC_CHANNELS[dacMappings.size()], cvOut, UINT32_MAX};
     dacMappings.push_back(mapping);
     PHNQ_LOG("  [DAC OUT %d] CV Out \"%s\"", mapping.channel == DacHandle::Channel::ONE ? 1 : 2, mapping.port->getId().c_str());
   }
 
   uint16_t gpioIndex = 0;
 
-  for (auto *param : engine->getParams())
+  for (auto *param : engineInstance->getParams())
   {
     if (param->getType() == phnq::engine::Param::BUTTON)
     {
@@ -182,7 +215,7 @@ void setupPinMappings()
     }
   }
 
-  for (auto *gateIn : engine->getGateIns())
+  for (auto *gateIn : engineInstance->getGateIns())
   {
     GPIOMapping<phnq::engine::GateIn> mapping;
     mapping.channel = GPIO_CHANNELS[gpioIndex++];
@@ -191,7 +224,7 @@ void setupPinMappings()
     PHNQ_LOG("  [D%d] Gate In \"%s\"", mapping.channel.index, mapping.port->getId().c_str());
   }
 
-  for (auto *gateOut : engine->getGateOuts())
+  for (auto *gateOut : engineInstance->getGateOuts())
   {
     GPIOMapping<phnq::engine::GateOut> mapping;
     mapping.channel = GPIO_CHANNELS[gpioIndex++];
@@ -200,7 +233,7 @@ void setupPinMappings()
     PHNQ_LOG("  [D%d] Gate Out \"%s\"", mapping.channel.index, mapping.port->getId().c_str());
   }
 
-  for (auto *light : engine->getLights())
+  for (auto *light : engineInstance->getLights())
   {
     LedMapping mapping;
     mapping.channel = GPIO_CHANNELS[gpioIndex++];
@@ -258,11 +291,16 @@ void configureIO()
 
 uint32_t numAudios = 0;
 
+float audioInBlocks[NUM_AUDIO_CHANNELS][AUDIO_BLOCK_SIZE];
+float audioOutBlocks[NUM_AUDIO_CHANNELS][AUDIO_BLOCK_SIZE];
+const float *const audioInBlockPtrs[NUM_AUDIO_CHANNELS] = {audioInBlocks[0], audioInBlocks[1]};
+float *const audioOutBlockPtrs[NUM_AUDIO_CHANNELS] = {audioOutBlocks[0], audioOutBlocks[1]};
+
 /**
  * @brief This callback does the following:
- * 1. Fills the engine's audio input port values with audio input data from the Seed.
- * 2. Calls `doProcess()` where audio processing is done.
- * 3. Copies the resulting audio output data into the Seed's output buffer.
+ * 1. De-interleaves the Seed's audio input into one buffer per audio input port.
+ * 2. Calls `doProcessBlock()` once for the whole block.
+ * 3. Interleaves the resulting audio output buffers into the Seed's output buffer.
  *
  * @param in
  * @param out
@@ -271,21 +309,24 @@ uint32_t numAudios = 0;
 static void AudioCallback(AudioHandle::InterleavingInputBuffer in, AudioHandle::InterleavingOutputBuffer out, size_t size)
 {
   numAudios += 1;
-  // PHNQ_LOG("AudioCallback: %d", engineInstance->doStuff());
 
-  // Iterate through audio buffer sample frames...
-  for (size_t i = 0; i < size; i += 2)
+  size_t numFrames = size / NUM_AUDIO_CHANNELS;
+
+  for (size_t frame = 0; frame < numFrames; frame++)
   {
-    for (AudioMapping<phnq::engine::AudioIn> audioInMapping : audioInMappings)
+    for (size_t channel = 0; channel < NUM_AUDIO_CHANNELS; channel++)
     {
-      audioInMapping.port->setValue(in[i + audioInMapping.index]);
+      audioInBlocks[channel][frame] = in[frame * NUM_AUDIO_CHANNELS + channel];
     }
+  }
 
-    engineInstance->doProcess(frameInfo);
+  engineInstance->doProcessBlock(frameInfo, numFrames, audioInBlockPtrs, audioOutBlockPtrs);
 
-    for (AudioMapping<phnq::engine::AudioOut> audioOutMapping : audioOutMappings)
+  for (size_t frame = 0; frame < numFrames; frame++)
+  {
+    for (size_t channel = 0; channel < NUM_AUDIO_CHANNELS; channel++)
     {
-      out[i + audioOutMapping.index] = audioOutMapping.port->getValue();
+      out[frame * NUM_AUDIO_CHANNELS + channel] = audioOutBlocks[channel][frame];
     }
   }
 }
@@ -299,49 +340,103 @@ void start()
   hw.StartAudio(AudioCallback);
 
   PHNQ_LOG("Start IO loop");
+  uint32_t lastStatsLogTime = System::GetNow();
   while (true)
   {
+    if (System::GetNow() - lastStatsLogTime >= SLEEP_STATS_LOG_INTERVAL_MS)
+    {
+      lastStatsLogTime = System::GetNow();
+      phnq::engine::SleepStats stats = engineInstance->getSleepStats();
+      PHNQ_LOG("Asleep %d%% of the time (%lu sleeps)",
+               stats.numFrames ? (int)(100 * stats.numAsleepFrames / stats.numFrames) : 0, (unsigned long)stats.numSleeps);
+    }
+
+    /**
+     * Input changes are posted to the engine rather than set directly, since the
+     * audio callback may interrupt this loop at any point. The engine applies them
+     * on the audio side at the next block boundary. A change that doesn't fit in
+     * the queue is retried on the next pass. ADC readings within `ADC_DEADBAND` of
+     * the last posted one are noise and not posted, so they can't wake the engine.
+     */
+
     // ADC -- Control Ins
-    for (ADCMapping<phnq::engine::CVIn> mapping : cvInMappings)
+    for (ADCMapping<phnq::engine::CVIn> &mapping : cvInMappings)
     {
-      mapping.port->setValue(hw.adc.GetFloat(mapping.channel.index) * 2.f - 1.f);
+      float value = hw.adc.GetFloat(mapping.channel.index);
+      if (phnq::engine::isAdcChange(value, mapping.postedValue) && engineInstance->postValue(mapping.port, value * 2.f - 1.f))
+      {
+        mapping.postedValue = value;
+      }
     }
 
     // ADC -- Params
-    for (ADCMapping<phnq::engine::Param> mapping : paramMappings)
+    for (ADCMapping<phnq::engine::Param> &mapping : paramMappings)
     {
-      mapping.port->setValue(hw.adc.GetFloat(mapping.channel.index));
+      float value = hw.adc.GetFloat(mapping.channel.index);
+      if (phnq::engine::isAdcChange(value, mapping.postedValue) && engineInstance->postValue(mapping.port, value))
+      {
+        mapping.postedValue = value;
+      }
     }
 
     // GPIO -- button ins
-    for (GPIOMapping<phnq::engine::Button> buttonMapping : buttonMappings)
+    for (GPIOMapping<phnq::engine::Button> &buttonMapping : buttonMappings)
     {
-      buttonMapping.port->setBoolValue(!buttonMapping.gpio->Read());
+      bool pressed = !buttonMapping.gpio->Read();
+      if (pressed != buttonMapping.postedValue && engineInstance->postValue(buttonMapping.port, pressed ? 1.f : 0.f))
+      {
+        buttonMapping.postedValue = pressed;
+      }
     }
 
     // GPIO -- gate ins
-    for (GPIOMapping<phnq::engine::GateIn> gpioInMapping : gpioInMappings)
+    for (GPIOMapping<phnq::engine::GateIn> &gpioInMapping : gpioInMappings)
     {
-      gpioInMapping.port->setValue(!gpioInMapping.gpio->Read());
+      bool high = !gpioInMapping.gpio->Read();
+      if (high != gpioInMapping.postedValue && engineInstance->postValue(gpioInMapping.port, high))
+      {
+        gpioInMapping.postedValue = high;
+      }
     }
 
-    // // DAC -- control outs
-    for (DACMapping dacMapping : dacMappings)
+    /**
+     * Outputs are only written when their port's generation has moved on. The
+     * generation is read before the value, so a change made by the audio callback
+     * in between is picked up on the next pass.
+     */
+
+    // DAC -- control outs
+    for (DACMapping &dacMapping : dacMappings)
     {
-      float cvOutVal = (dacMapping.port->getValue() + 1.f) / 2.f;
-      hw.dac.WriteValue(dacMapping.channel, (uint16_t)roundf(cvOutVal * 4095.f));
+      uint32_t generation = dacMapping.port->getGeneration();
+      if (generation != dacMapping.sentGeneration)
+      {
+        dacMapping.sentGeneration = generation;
+        float cvOutVal = (dacMapping.port->getValue() + 1.f) / 2.f;
+        hw.dac.WriteValue(dacMapping.channel, (uint16_t)roundf(cvOutVal * 4095.f));
+      }
     }
 
-    // // GPIO -- gate outs
-    for (GPIOMapping<phnq::engine::GateOut> gpioOutMapping : gpioOutMappings)
+    // GPIO -- gate outs
+    for (GPIOMapping<phnq::engine::GateOut> &gpioOutMapping : gpioOutMappings)
     {
-      gpioOutMapping.gpio->Write(gpioOutMapping.port->getValue());
+      uint32_t generation = gpioOutMapping.port->getGeneration();
+      if (generation != gpioOutMapping.sentGeneration)
+      {
+        gpioOutMapping.sentGeneration = generation;
+        gpioOutMapping.gpio->Write(gpioOutMapping.port->getValue());
+      }
     }
 
-    // // LEDs
-    for (LedMapping ledMapping : ledMappings)
+    // LEDs -- `Update()` runs the software PWM, so it is called on every pass.
+    for (LedMapping &ledMapping : ledMappings)
     {
-      ledMapping.led->Set(ledMapping.port->getValue());
+      uint32_t generation = ledMapping.port->getGeneration();
+      if (generation != ledMapping.sentGeneration)
+      {
+        ledMapping.sentGeneration = generation;
+        ledMapping.led->Set(ledMapping.port->getValue());
+      }
       ledMapping.led->Update();
     }
 
@@ -2,6 +2,8 @@
 #include <daisysp.h>
 #include <vector>
 #include "../../core/Engine.hpp"
+#include "../../core/dsp/VoicePool.hpp"
+#include "../../core/dsp/ChordStore.hpp"
 
 /**
  * Polyphonic oscillator where you can program a chord progression. The
@@ -43,11 +45,34 @@ using namespace daisysp;
 
 using Osc = VariableSawOscillator;
 
+// Voices ChordSeq sounds at most, each a pair of oscillators; notes beyond it
+// steal voices (see phnq::VoicePool). Override with -DCHORDSEQ_MAX_POLYPHONY=n.
+#ifndef CHORDSEQ_MAX_POLYPHONY
+#define CHORDSEQ_MAX_POLYPHONY 16
+#endif
+
+// Sequence capacity, fixed so that editing never allocates.
+const size_t CHORDSEQ_MAX_CHORDS = 64;
+const size_t CHORDSEQ_MAX_NOTES = 512;
+typedef ChordStore<CHORDSEQ_MAX_CHORDS, CHORDSEQ_MAX_NOTES> ChordSeqChordStore;
+
+/**
+ * @brief The pitch and detune a voice's oscillators were last tuned to, so they
+ * are only retuned when either changes.
+ */
+struct VoiceFrequency
+{
+  float pitch;
+  float detune;
+};
+
 struct ChordSeq : phnq::Engine
 {
   size_t chordIndex = 0;
-  vector<vector<float>> chords;
-  vector<Osc *> oscillators;
+  ChordSeqChordStore chordStore; // Edited by the event handlers, read by process().
+  Osc oscillators[CHORDSEQ_MAX_POLYPHONY * 2];
+  VoiceFrequency voiceFrequencies[CHORDSEQ_MAX_POLYPHONY]; // One per pair of oscillators.
+  VoicePool voicePool = VoicePool(CHORDSEQ_MAX_POLYPHONY);
   bool isChordInsert = false;
 
   IOPort *nextChordGate;
@@ -106,7 +131,7 @@ struct ChordSeq : phnq::Engine
   void nextChord()
   {
     chordIndex++;
-    chordIndex = chordIndex % chords.size();
+    chordIndex = chordIndex % chordStore.edited().size();
   }
 
   void reset()
@@ -116,66 +141,66 @@ struct ChordSeq : phnq::Engine
 
   void insertChord()
   {
-    chords.insert(chords.begin() + chordIndex, vector<float>());
+    chordStore.insertChord(chordIndex);
   }
 
   void appendChord()
   {
     chordIndex++;
-    if (chordIndex > chords.size())
+    if (chordIndex > chordStore.edited().size())
     {
-      chordIndex = chords.size();
+      chordIndex = chordStore.edited().size();
     }
-    chords.insert(chords.begin() + chordIndex, vector<float>());
+    chordStore.insertChord(chordIndex);
   }
 
   void removeChord()
   {
-    chords.erase(chords.begin() + chordIndex);
+    chordStore.removeChord(chordIndex);
   }
 
   void addNoteToCurrentChord(float pitch)
   {
-    while (chordIndex >= chords.size())
+    while (chordIndex >= chordStore.edited().size() && chordStore.edited().size() < CHORDSEQ_MAX_CHORDS)
     {
       appendChord();
     }
-    chords[chordIndex].push_back(pitch);
+    chordStore.addNote(chordIndex, pitch);
 
-    adjustOscillatorPool();
+    adjustVoicePool();
   }
 
-  void adjustOscillatorPool()
+  /**
+   * @brief Activate enough voices for the largest chord, within the polyphony.
+   * Oscillators are preallocated, so this never allocates.
+   */
+  void adjustVoicePool()
   {
-    float shape = this->shapeParam->getValue();
+    size_t maxChordSize = chordStore.edited().maxChordSize();
 
-    size_t oscillatorsNeeded = 0;
-    for (vector<float> chord : chords)
-    {
-      oscillatorsNeeded = std::max(oscillatorsNeeded, chord.size() * 2);
-    }
-    while (oscillators.size() < oscillatorsNeeded)
+    // Voices activated since the pool was last smaller start from scratch.
+    for (size_t voice = voicePool.activate(maxChordSize); voice < voicePool.getNumActive(); voice++)
     {
-      Osc *osc = new Osc();
-      osc->Init(getFrameInfo().sampleRate);
-      osc->SetWaveshape(shape);
-      oscillators.push_back(osc);
+      initVoice(voice, getFrameInfo().sampleRate);
     }
-    while (oscillators.size() > oscillatorsNeeded)
+  }
+
+  void initVoice(size_t voice, float sampleRate)
+  {
+    float shape = this->shapeParam->getValue();
+    for (size_t i = 2 * voice; i < 2 * voice + 2; i++)
     {
-      Osc *osc = oscillators.back();
-      oscillators.pop_back();
-      delete osc;
+      oscillators[i].Init(sampleRate);
+      oscillators[i].SetWaveshape(shape);
     }
+    voiceFrequencies[voice].pitch = NAN;
   }
 
   void sampleRateDidChange(float sampleRate) override
   {
-    float shape = this->shapeParam->getValue();
-    for (Osc *osc : oscillators)
+    for (size_t voice = 0; voice < CHORDSEQ_MAX_POLYPHONY; voice++)
     {
-      osc->Init(sampleRate);
-      osc->SetWaveshape(shape);
+      initVoice(voice, sampleRate);
     }
   }
 
@@ -233,35 +258,49 @@ struct ChordSeq : phnq::Engine
     PHNQ_LOG("======= cvValueDidChange");
     if (cvPort == addNotePitch && addNoteButton->getGateValue())
     {
-      vector<float> chord = chords[chordIndex];
-      chord.pop_back();
-      chord.push_back(value); // TODO quantize this value
+      size_t chordSize = chordStore.edited().chordSize(chordIndex);
+      if (chordSize > 0)
+      {
+        chordStore.setNote(chordIndex, chordSize - 1, value); // TODO quantize this value
+      }
     }
   }
 
   void process(FrameInfo frameInfo) override
   {
-    vector<float> chord = chords[chordIndex];
+    const ChordSeqChordStore::Chords &chords = chordStore.read();
+    if (chordIndex >= chords.size())
+    {
+      audioOut1->setValue(0.f);
+      audioOut2->setValue(0.f);
+      return;
+    }
     float amp1 = 0.f, amp2 = 0.f;
-    size_t chordSize = chord.size();
-    for (size_t i = 0; i < chordSize; i++)
+    size_t chordSize = chords.chordSize(chordIndex);
+    size_t numVoices = voicePool.numVoicesFor(chordSize);
+    for (size_t i = 0; i < numVoices; i++)
     {
-      float pitch = chord[i];
+      float pitch = chords.note(chordIndex, voicePool.noteForVoice(i, chordSize));
 
       float detune = this->detuneParam->getValue() / 100.f;
 
-      float freq1 = pitchToFrequency(pitch);
-      float freq2 = pitchToFrequency(pitch + detune);
-
       float shape = this->shapeParam->getValue();
 
-      Osc *osc1 = oscillators[2 * i];
-      osc1->SetFreq(freq1);
+      Osc *osc1 = &oscillators[2 * i];
+      Osc *osc2 = &oscillators[2 * i + 1];
+
+      VoiceFrequency &frequency = voiceFrequencies[i];
+      if (pitch != frequency.pitch || detune != frequency.detune)
+      {
+        osc1->SetFreq(pitchToFrequency(pitch));
+        osc2->SetFreq(pitchToFrequency(pitch + detune));
+        frequency.pitch = pitch;
+        frequency.detune = detune;
+      }
+
       osc1->SetWaveshape(shape);
       amp1 += osc1->Process();
 
-      Osc *osc2 = oscillators[2 * i + 1];
-      osc2->SetFreq(freq2);
       osc2->SetWaveshape(shape);
       amp2 += osc2->Process();
     }
@@ -286,3 +325,8 @@ rack::plugin::Model *modelChordSeq = rack::createModel<RackModule<ChordSeq>, Cho
 #include "../../core/seed/SeedModule.hpp"
 Engine *moduleInstance = new ChordSeq();
 #endif
+
+#ifdef PHNQ_HOST
+#include "../../core/host/HostModule.hpp"
+Engine *moduleInstance = new ChordSeq();
+#endif
@@ -1,12 +1,55 @@
-#include "../../core2/engine/Engine.hpp"
-#include <daisysp.h>
+#include "../../core2/engine/StaticEngine.hpp"
+#include "../../core/simd/Simd.hpp"
+#include "../../core/dsp/VoiceBank.hpp"
+#include "../../core/dsp/VoicePool.hpp"
+#include "../../core/dsp/ChordStore.hpp"
+#include <algorithm>
 
 using namespace phnq::engine;
 
-using Osc = daisysp::VariableShapeOscillator;
-using Glide = daisysp::Port;
+// Voices PolyVox sounds at most, however many notes a chord has; up to
+// MAX_BANK_VOICES. Builds with a tighter CPU budget (e.g. the Seed) can lower it
+// with -DPOLYVOX_MAX_POLYPHONY=8.
+#ifndef POLYVOX_MAX_POLYPHONY
+#define POLYVOX_MAX_POLYPHONY 16
+#endif
+static_assert(POLYVOX_MAX_POLYPHONY >= 1 && POLYVOX_MAX_POLYPHONY <= phnq::MAX_BANK_VOICES, "POLYVOX_MAX_POLYPHONY must be 1 to MAX_BANK_VOICES");
+
+// Sequence capacity, fixed so that editing never allocates. Notes are 16-bit,
+// so the defaults take 20KB per buffer (the store keeps three).
+#ifndef POLYVOX_MAX_CHORDS
+#define POLYVOX_MAX_CHORDS 2048
+#endif
+#ifndef POLYVOX_MAX_NOTES
+#define POLYVOX_MAX_NOTES 8192
+#endif
+typedef phnq::ChordStore<POLYVOX_MAX_CHORDS, POLYVOX_MAX_NOTES> PolyVoxChordStore;
+
+// Builds can start PolyVox on band-limited wavetable oscillators with
+// -DPOLYVOX_WAVETABLE=1. With the scalar SIMD backend, as on the Seed, they take
+// about half the CPU per voice of the default polyBLEP ones; where polyBLEP is
+// vectorized (x86, ARM64) it stays faster.
+#ifndef POLYVOX_WAVETABLE
+#define POLYVOX_WAVETABLE 0
+#endif
 
-struct PolyVox : Engine, GateIn::GateChangeListener, CVIn::CVInChangeListener, Button::ButtonChangeListener
+typedef PortSchema<
+    0, // audio ins
+    2, // audio outs
+    5, // CV ins
+    0, // CV outs
+    3, // gate ins
+    0, // gate outs
+    4, // params
+    2, // buttons
+    5  // lights
+    >
+    PolyVoxPorts;
+
+// Knob time constant, long enough to hide the Seed's ADC steps.
+const float KNOB_SMOOTHING_TIME = 0.01f;
+
+struct PolyVox : StaticEngine<PolyVoxPorts>, GateIn::GateChangeListener, CVIn::CVInChangeListener, Button::ButtonChangeListener
 {
   /*****************
    ***** PORTS *****
@@ -14,8 +57,9 @@ struct PolyVox : Engine, GateIn::GateChangeListener, CVIn::CVInChangeListener, B
   GateIn *resetSeqGateIn = createGateIn("reset")->setListener(this);
   GateIn *advanceSeqGateIn = createGateIn("trigger")->setListener(this);
 
-  AudioOut *audioOutLeft = createAudioOut("audioOutLeft");
-  AudioOut *audioOutRight = createAudioOut("audioOutRight");
+  // In Rack, one channel per chord voice; elsewhere the mix.
+  AudioOut *audioOutLeft = createAudioOut("audioOutLeft")->setPolyphonic(true);
+  AudioOut *audioOutRight = createAudioOut("audioOutRight")->setPolyphonic(true);
 
   GateIn *addNoteGateIn = createGateIn("addNoteGate")->setListener(this);
   CVIn *addNoteCVIn = createCVIn("addNoteCV")->setListener(this);
@@ -29,10 +73,10 @@ struct PolyVox : Engine, GateIn::GateChangeListener, CVIn::CVInChangeListener, B
   Light *seqPos3LED = createLight("seqPos3");
   Light *seqPos4LED = createLight("seqPos4");
 
-  Param *tuneKnob = createParam("tune")->setListener(this);
-  Param *detuneKnob = createParam("detune")->setListener(this);
-  Param *shapeKnob = createParam("shape")->setListener(this);
-  Param *glideKnob = createParam("glide")->setListener(this);
+  Param *tuneKnob = createParam("tune")->setListener(this)->setSmoothing(KNOB_SMOOTHING_TIME);
+  Param *detuneKnob = createParam("detune")->setListener(this)->setSmoothing(KNOB_SMOOTHING_TIME);
+  Param *shapeKnob = createParam("shape")->setListener(this)->setSmoothing(KNOB_SMOOTHING_TIME);
+  Param *glideKnob = createParam("glide")->setListener(this)->setSmoothing(KNOB_SMOOTHING_TIME);
 
   CVIn *tuneCVIn = createCVIn("tuneCV")->setListener(this);
   CVIn *detuneCVIn = createCVIn("detuneCV")->setListener(this);
@@ -42,14 +86,27 @@ struct PolyVox : Engine, GateIn::GateChangeListener, CVIn::CVInChangeListener, B
   /*****************
    ***** STATE *****
    *****************/
-  uint8_t seqPos = 0;
+  uint16_t seqPos = 0;
   bool isWriteMode = false;
-  std::vector<std::vector<float>> chords;
-  std::vector<Osc *> oscillators;
-  std::vector<Glide *> glides;
+  PolyVoxChordStore chordStore; // Edited by the event handlers, read by renderFrames().
+
+  // The current step's notes, decoded for the voices, and what they were decoded from.
+  float stepNotes[POLYVOX_MAX_POLYPHONY] = {};
+  uint32_t stepVersion = 0;
+  size_t stepSeqPos = SIZE_MAX;
+  size_t stepNumVoices = 0;
+  phnq::VoiceBank voices;
+  phnq::VoicePool voicePool = phnq::VoicePool(POLYVOX_MAX_POLYPHONY);
+
+  // Control-rate values, updated in processControl().
+  float tune = 0.f;
+  float detune = 0.f;
+  float shape = 0.f;
+  float glideTime = 0.f;
 
   PolyVox()
   {
+    voices.setWavetable(POLYVOX_WAVETABLE);
     updateLEDs();
   }
 
@@ -103,15 +160,22 @@ struct PolyVox : Engine, GateIn::GateChangeListener, CVIn::CVInChangeListener, B
     if (isWriteMode != enabled)
     {
       isWriteMode = enabled;
+      size_t numChords = chordStore.edited().size();
 
       if (isWriteMode)
       {
-        chords.push_back(std::vector<float>());
-        seqPos = chords.size() - 1;
+        if (chordStore.insertChord(numChords))
+        {
+          seqPos = numChords;
+        }
+        else
+        {
+          isWriteMode = false; // The sequence is full.
+        }
       }
-      else if (chords[seqPos].empty())
+      else if (chordStore.edited().chordSize(seqPos) == 0)
       {
-        chords.pop_back();
+        chordStore.removeChord(numChords - 1);
         if (seqPos > 0)
         {
           seqPos--;
@@ -123,19 +187,18 @@ struct PolyVox : Engine, GateIn::GateChangeListener, CVIn::CVInChangeListener, B
 
   void deleteLastChord()
   {
-    if (!chords.empty())
+    if (chordStore.removeChord(chordStore.edited().size() - 1))
     {
-      chords.pop_back();
-
-      if (chords.empty())
+      size_t numChords = chordStore.edited().size();
+      if (numChords == 0)
       {
         seqPos = 0;
       }
-      else if (seqPos >= chords.size())
+      else if (seqPos >= numChords)
       {
-        seqPos = chords.size() - 1;
+        seqPos = numChords - 1;
       }
-      adjustOscillatorPool();
+      adjustVoicePool();
       updateLEDs();
       logChords();
     }
@@ -143,8 +206,8 @@ struct PolyVox : Engine, GateIn::GateChangeListener, CVIn::CVInChangeListener, B
 
   void addNoteToChord()
   {
-    chords[seqPos].push_back(addNoteCVIn->getValue());
-    adjustOscillatorPool();
+    chordStore.addNote(seqPos, addNoteCVIn->getValue());
+    adjustVoicePool();
     logChords();
   }
 
@@ -158,7 +221,7 @@ struct PolyVox : Engine, GateIn::GateChangeListener, CVIn::CVInChangeListener, B
   void advanceSequence()
   {
     setChordWriteModeEnabled(false);
-    seqPos = (seqPos + 1) % chords.size();
+    seqPos = (seqPos + 1) % chordStore.edited().size();
     updateLEDs();
   }
 
@@ -173,107 +236,163 @@ struct PolyVox : Engine, GateIn::GateChangeListener, CVIn::CVInChangeListener, B
     seqPos4LED->setValue((seqPos + 1) & 1 << 3 ? 1.f : 0.f);
   }
 
-  void adjustOscillatorPool()
+  /**
+   * @brief Set how many voices may sound at once, up to `POLYVOX_MAX_POLYPHONY`.
+   * Notes beyond it steal voices (see `phnq::VoicePool`).
+   */
+  void setMaxPolyphony(size_t maxPolyphony)
   {
-    size_t maxChordSize = 0;
-    for (std::vector<float> chord : chords)
-    {
-      maxChordSize = std::max(maxChordSize, chord.size());
-    }
+    voicePool.setMaxVoices(std::min<size_t>(maxPolyphony, POLYVOX_MAX_POLYPHONY));
+    adjustVoicePool();
+  }
 
-    while (glides.size() < maxChordSize)
-    {
-      Glide *glide = new Glide();
-      glide->Init(getFrameInfo().sampleRate, glideKnob->getValue() + glideCVIn->getValue());
-      glides.push_back(glide);
-    }
-    while (glides.size() > maxChordSize)
-    {
-      Glide *glide = glides.back();
-      glides.pop_back();
-      delete glide;
-    }
+  /**
+   * @brief Switch the oscillators between band-limited wavetables and polyBLEP
+   * (see `phnq::VoiceBank::setWavetable()`).
+   */
+  void setWavetable(bool wavetable)
+  {
+    voices.setWavetable(wavetable);
+  }
 
-    size_t oscillatorsNeeded = maxChordSize * 2;
-    while (oscillators.size() < oscillatorsNeeded)
-    {
-      Osc *osc = new Osc();
-      osc->Init(getFrameInfo().sampleRate);
-      oscillators.push_back(osc);
-    }
-    while (oscillators.size() > oscillatorsNeeded)
+  /**
+   * @brief Activate enough voices for the largest chord, within the polyphony.
+   * Voices live in the bank, so this never allocates.
+   */
+  void adjustVoicePool()
+  {
+    size_t maxChordSize = chordStore.edited().maxChordSize();
+
+    // Voices activated since the pool was last smaller start from scratch.
+    for (size_t voice = voicePool.activate(maxChordSize); voice < voicePool.getNumActive(); voice++)
     {
-      Osc *osc = oscillators.back();
-      oscillators.pop_back();
-      delete osc;
+      voices.initVoice(voice);
     }
+
+    // New voices need their coefficients before they are next processed.
+    updateVoices();
+  }
+
+  /**
+   * @brief Read the knobs and CVs, and push the resulting coefficients to all voices.
+   */
+  void updateVoices()
+  {
+    tune = (this->tuneKnob->getValue() - 0.5f + this->tuneCVIn->getValue()) / 2.5f;
+    detune = (this->detuneKnob->getValue() + this->detuneCVIn->getValue()) / 100.f;
+    shape = this->shapeKnob->getValue() + this->shapeCVIn->getValue();
+    glideTime = isWriteMode ? 0 : this->glideKnob->getValue() + this->glideCVIn->getValue();
+
+    voices.setGlideTime(glideTime);
+    voices.setDetune(detune);
+    voices.setShape(shape);
+    voices.setPulseWidth(0.5f);
   }
 
   void logChords()
   {
+    // const PolyVoxChordStore::Chords &chords = chordStore.edited();
     // PHNQ_LOG("num chords: %lu", chords.size());
-    // for (vector<float> chord : chords)
+    // for (size_t i = 0; i < chords.size(); i++)
     // {
     //   PHNQ_LOG("chord");
-    //   for (float note : chord)
+    //   for (size_t j = 0; j < chords.chordSize(i); j++)
     //   {
-    //     PHNQ_LOG("- %f", pitchToFrequency(note));
+    //     PHNQ_LOG("- %f", pitchToFrequency(chords.note(i, j)));
     //   }
     // }
   }
 
   void sampleRateDidChange(float sampleRate) override
   {
-    for (Osc *osc : oscillators)
-    {
-      osc->Init(sampleRate);
-    }
+    voices.init(sampleRate, FREQ_C1);
+    voices.setGlideTime(glideKnob->getValue() + glideCVIn->getValue());
+  }
 
-    for (Glide *glide : glides)
-    {
-      glide->Init(sampleRate, glideKnob->getValue() + glideCVIn->getValue());
-    }
+  bool isIdle() override
+  {
+    return chordStore.read().empty();
+  }
+
+  void processControl(FrameInfo frameInfo) override
+  {
+    updateVoices();
   }
 
   void process(FrameInfo frameInfo) override
   {
-    float amp1 = 0.f, amp2 = 0.f;
+    float left, right;
+    renderFrames(&left, &right, 1, audioOutLeft->getChannelValues(), audioOutRight->getChannelValues());
 
-    if (!chords.empty())
-    {
-      float tune = (this->tuneKnob->getValue() - 0.5f + this->tuneCVIn->getValue()) / 2.5f;
-      float detune = (this->detuneKnob->getValue() + this->detuneCVIn->getValue()) / 100.f;
-      float shape = this->shapeKnob->getValue() + this->shapeCVIn->getValue();
-      float glideTime = isWriteMode ? 0 : this->glideKnob->getValue() + this->glideCVIn->getValue();
-
-      std::vector<float> chord = chords[seqPos];
-      size_t chordSize = chord.size();
-      for (size_t i = 0; i < chordSize; i++)
-      {
-        Glide *glide = glides[i];
-        glide->SetHtime(glideTime);
+    audioOutLeft->setValue(left);
+    audioOutRight->setValue(right);
+  }
+
+  void processBlock(FrameInfo frameInfo, size_t numFrames) override
+  {
+    float *left = audioOutLeft->getBlock();
+    float *right = audioOutRight->getBlock();
+    renderFrames(left, right, numFrames, NULL, NULL);
 
-        float pitch = glide->Process(chord[i] + tune);
+    phnq::simd::clamp(left, -2.f, 2.f, left, numFrames);
+    phnq::simd::clamp(right, -2.f, 2.f, right, numFrames);
+  }
+
+  /**
+   * @brief Render `numFrames` frames of the current chord, running the voice bank
+   * across the block. Coefficients are set at control rate by `updateVoices()`.
+   *
+   * @param voicesLeft if not NULL, receives each voice's last left sample, scaled
+   * like the mix, so the voices sum to it. Up to `POLYVOX_MAX_POLYPHONY` voices.
+   * @param voicesRight same as `voicesLeft` for the right side.
+   */
+  void renderFrames(float *left, float *right, size_t numFrames, float *voicesLeft, float *voicesRight)
+  {
+    phnq::simd::fill(left, 0.f, numFrames);
+    phnq::simd::fill(right, 0.f, numFrames);
+
+    // The sequence as last published; seqPos may run ahead of it if edited from
+    // another thread.
+    const PolyVoxChordStore::Chords &chords = chordStore.read();
+    size_t chordSize = seqPos < chords.size() ? chords.chordSize(seqPos) : 0;
+    size_t numVoices = voicePool.numVoicesFor(chordSize);
+    if (voicesLeft)
+    {
+      audioOutLeft->setChannels(numVoices);
+      audioOutRight->setChannels(numVoices);
+      std::fill(voicesLeft, voicesLeft + MAX_CHANNELS, 0.f);
+      std::fill(voicesRight, voicesRight + MAX_CHANNELS, 0.f);
+    }
 
-        float freq1 = pitchToFrequency(pitch - detune);
-        float freq2 = pitchToFrequency(pitch + detune);
+    if (numVoices > 0)
+    {
+      // Decode the step's notes only when the step or the sequence changes.
+      if (seqPos != stepSeqPos || chords.version != stepVersion || numVoices != stepNumVoices)
+      {
+        for (size_t voice = 0; voice < numVoices; voice++)
+        {
+          stepNotes[voice] = chords.note(seqPos, voicePool.noteForVoice(voice, chordSize));
+        }
+        stepSeqPos = seqPos;
+        stepVersion = chords.version;
+        stepNumVoices = numVoices;
+      }
 
-        Osc *osc1 = oscillators[2 * i];
-        osc1->SetSyncFreq(freq1);
-        osc1->SetWaveshape(shape);
-        osc1->SetPW(0.5f);
-        amp1 += osc1->Process();
+      for (size_t voice = 0; voice < numVoices; voice++)
+      {
+        voices.setNote(voice, stepNotes[voice] + tune);
+      }
+      voices.process(numVoices, left, right, numFrames, voicesLeft, voicesRight);
 
-        Osc *osc2 = oscillators[2 * i + 1];
-        osc2->SetSyncFreq(freq2);
-        osc2->SetWaveshape(shape);
-        osc2->SetPW(0.5f);
-        amp2 += osc2->Process();
+      if (voicesLeft)
+      {
+        phnq::simd::scale(voicesLeft, 0.5f, voicesLeft, numVoices);
+        phnq::simd::scale(voicesRight, 0.5f, voicesRight, numVoices);
       }
     }
 
-    audioOutLeft->setValue(amp1 * 0.5f);
-    audioOutRight->setValue(amp2 * 0.5f);
+    phnq::simd::scale(left, 0.5f, left, numFrames);
+    phnq::simd::scale(right, 0.5f, right, numFrames);
   }
 };
 
@@ -309,7 +428,25 @@ struct PolyVoxUI : phnq::vcv::RackModuleUI<PolyVox>
 rack::plugin::Model *modelPolyVox = rack::createModel<phnq::vcv::RackModule<PolyVox>, PolyVoxUI>("PolyVox");
 #endif
 
+// Seed and host builds can run PolyVox oversampled (2, 4 or 8), e.g. with
+// -DPOLYVOX_OVERSAMPLING=2, trading CPU for less aliasing from its oscillators.
+#ifndef POLYVOX_OVERSAMPLING
+#define POLYVOX_OVERSAMPLING 1
+#endif
+
+#if POLYVOX_OVERSAMPLING > 1
+#include "../../core2/engine/Oversampled.hpp"
+typedef phnq::engine::Oversampled<PolyVox, POLYVOX_OVERSAMPLING> PolyVoxInstance;
+#else
+typedef PolyVox PolyVoxInstance;
+#endif
+
 #ifdef PHNQ_SEED
-Engine *engineInstance = new PolyVox();
 #include "../../core2/seed/SeedModule.hpp"
+Engine *engineInstance = createSeedEngine<PolyVoxInstance>();
+#endif
+
+#ifdef PHNQ_HOST
+Engine *engineInstance = new PolyVoxInstance();
+#include "../../core2/host/HostModule.hpp"
 #endif
@@ -78,3 +78,8 @@ rack::plugin::Model *modelTestModule = rack::createModel<RackModule<TestModule>,
 #include "../../core/seed/SeedModule.hpp"
 Engine *moduleInstance = new TestModule();
 #endif
+
+#ifdef PHNQ_HOST
+#include "../../core/host/HostModule.hpp"
+Engine *moduleInstance = new TestModule();
+#endif
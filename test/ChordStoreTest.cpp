@@ -0,0 +1,199 @@
+#include <stdlib.h>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "../src/core/dsp/ChordStore.hpp"
+#include "Test.hpp"
+
+/**
+ * Chord Store Tests
+ * =================
+ * Random edits (insert, remove, add note, set note, clear) checked against a
+ * plain `vector<vector<float>>` model. Publishing copies only what the editor's
+ * next buffer missed, so the player reads at varying rates to leave that buffer
+ * anywhere from one edit behind to past the edit log. A second test edits and
+ * plays on two threads; every published view must be one the editor made.
+ */
+
+using namespace phnq;
+using namespace phnq::test;
+
+const size_t MAX_CHORDS = 64;
+const size_t MAX_NOTES = 512;
+typedef ChordStore<MAX_CHORDS, MAX_NOTES> Store;
+typedef std::vector<std::vector<float>> Model;
+
+static bool matches(const Store::Chords &chords, const Model &model)
+{
+  if (chords.size() != model.size())
+  {
+    return false;
+  }
+  size_t maxChordSize = 0;
+  for (size_t chord = 0; chord < model.size(); chord++)
+  {
+    if (chords.chordSize(chord) != model[chord].size())
+    {
+      return false;
+    }
+    for (size_t note = 0; note < model[chord].size(); note++)
+    {
+      if (chords.note(chord, note) != model[chord][note])
+      {
+        return false;
+      }
+    }
+    maxChordSize = model[chord].size() > maxChordSize ? model[chord].size() : maxChordSize;
+  }
+  return chords.maxChordSize() == maxChordSize;
+}
+
+/**
+ * @brief Make one random edit to both the store and the model. Edits that
+ * would overflow the store are skipped in both.
+ */
+static void editRandomly(Store &store, Model &model)
+{
+  float pitch = (float)(rand() % 2000 - 1000) / 1000.f;
+  float code = decodePitch(encodePitch(pitch));
+  int op = rand() % 20;
+  if (op < 4 || model.empty())
+  {
+    size_t index = rand() % (model.size() + 1);
+    if (store.insertChord(index))
+    {
+      model.insert(model.begin() + index, std::vector<float>());
+    }
+  }
+  else if (op < 7)
+  {
+    size_t index = rand() % model.size();
+    store.removeChord(index);
+    model.erase(model.begin() + index);
+  }
+  else if (op < 16)
+  {
+    size_t index = rand() % model.size();
+    if (store.addNote(index, pitch))
+    {
+      model[index].push_back(code);
+    }
+  }
+  else if (op < 19)
+  {
+    size_t index = rand() % model.size();
+    if (!model[index].empty())
+    {
+      size_t note = rand() % model[index].size();
+      store.setNote(index, note, pitch);
+      model[index][note] = code;
+    }
+  }
+  else if (rand() % 8 == 0)
+  {
+    store.clear();
+    model.clear();
+  }
+}
+
+static void testEditsMatchModel()
+{
+  const size_t NUM_SEQUENCES = 200;
+  const size_t NUM_EDITS = 500;
+
+  bool editedMatches = true;
+  bool readMatches = true;
+  for (size_t sequence = 0; sequence < NUM_SEQUENCES; sequence++)
+  {
+    std::unique_ptr<Store> store(new Store());
+    Model model;
+
+    // From every edit down to one in twelve, i.e. beyond the edit log.
+    size_t readInterval = 1 + sequence % 12;
+    for (size_t edit = 0; edit < NUM_EDITS && editedMatches && readMatches; edit++)
+    {
+      editRandomly(*store, model);
+      editedMatches &= matches(store->edited(), model);
+      if (edit % readInterval == 0)
+      {
+        readMatches &= matches(store->read(), model);
+      }
+    }
+  }
+
+  check(editedMatches, "chord store: edited sequence matches the model after every edit");
+  check(readMatches, "chord store: the player reads the latest edits");
+}
+
+static void testTwoThreads()
+{
+  const uint32_t NUM_EDITS = 100000;
+
+  // The hash of each version, written by the editor just after publishing it.
+  std::unique_ptr<std::atomic<uint32_t>[]> hashes(new std::atomic<uint32_t>[NUM_EDITS + 1]);
+  std::unique_ptr<Store> store(new Store());
+  std::atomic<bool> isEditing(true);
+
+  auto hash = [](const Store::Chords &chords)
+  {
+    uint32_t h = 2166136261u;
+    for (size_t chord = 0; chord < chords.size(); chord++)
+    {
+      h = (h ^ (uint32_t)(chords.chordSize(chord) + 1)) * 16777619u;
+      for (size_t note = 0; note < chords.chordSize(chord); note++)
+      {
+        h = (h ^ (uint16_t)chords.notes[chords.offsets[chord] + note]) * 16777619u;
+      }
+    }
+    return h;
+  };
+
+  // After publishing, the editor's buffer is a copy of what it published.
+  std::thread editor([&]()
+                     {
+                       Model model;
+                       hashes[0] = hash(store->edited());
+                       while (store->edited().version < NUM_EDITS)
+                       {
+                         uint32_t version = store->edited().version;
+                         editRandomly(*store, model);
+                         if (store->edited().version != version)
+                         {
+                           hashes[store->edited().version].store(hash(store->edited()), std::memory_order_release);
+                         }
+                       }
+                       isEditing = false; });
+
+  size_t numReads = 0;
+  size_t numTorn = 0;
+  uint32_t lastVersion = 0;
+  bool isMonotonic = true;
+  while (isEditing)
+  {
+    const Store::Chords &chords = store->read();
+    isMonotonic &= chords.version >= lastVersion;
+    lastVersion = chords.version;
+
+    // The hash is written just after the edit publishes; wait for it.
+    uint32_t expected;
+    while ((expected = hashes[chords.version].load(std::memory_order_acquire)) == 0 && isEditing)
+    {
+      std::this_thread::yield();
+    }
+    numTorn += expected != 0 && hash(chords) != expected ? 1 : 0;
+    numReads++;
+  }
+  editor.join();
+
+  printf("%lu reads\n", (unsigned long)numReads);
+  check(numTorn == 0, "chord store: every view the player reads is a whole edit");
+  check(isMonotonic, "chord store: the player never goes back a version");
+}
+
+int main(int argc, char **argv)
+{
+  testEditsMatchModel();
+  testTwoThreads();
+  return result();
+}
@@ -0,0 +1,92 @@
+#include "../src/core2/engine/EngineGraph.hpp"
+#include "Test.hpp"
+
+/**
+ * Engine Graph Tests
+ * ==================
+ * A graph whose output goes silent while its nodes still drive each other must
+ * stay awake: here a clock gates a voice, with long gaps between pulses.
+ */
+
+using namespace phnq::engine;
+using namespace phnq::test;
+
+const float SAMPLE_RATE = 48000.f;
+const size_t BLOCK_SIZE = 48;
+const size_t CLOCK_PERIOD = 96000; // Frames; two seconds.
+const size_t CLOCK_PULSE = 4800;   // Frames the gate stays high each period.
+const size_t NUM_PERIODS = 5;
+
+typedef PortSchema<0, 0, 0, 0, 0, 1, 0, 0, 0> ClockPorts;
+
+/**
+ * @brief Gate high for `CLOCK_PULSE` frames at the start of every `CLOCK_PERIOD`.
+ */
+struct Clock : StaticEngine<ClockPorts>
+{
+  GateOut *gateOut = createGateOut("gateOut");
+  size_t frame = 0;
+
+protected:
+  void processBlock(FrameInfo frameInfo, size_t numFrames) override
+  {
+    gateOut->setValue(frame % CLOCK_PERIOD < CLOCK_PULSE);
+    frame += numFrames;
+  }
+};
+
+typedef PortSchema<0, 1, 0, 0, 1, 0, 0, 0, 0> VoicePorts;
+
+/**
+ * @brief Full scale while its gate is high, silent otherwise.
+ */
+struct Voice : StaticEngine<VoicePorts>
+{
+  GateIn *gateIn = createGateIn("gateIn");
+  AudioOut *audioOut = createAudioOut("audioOut");
+
+protected:
+  void processBlock(FrameInfo frameInfo, size_t numFrames) override
+  {
+    std::fill(audioOut->getBlock(), audioOut->getBlock() + numFrames, gateIn->getValue() ? 1.f : 0.f);
+  }
+};
+
+typedef PortSchema<0, 1, 0, 0, 0, 0, 0, 0, 0> ClockedVoicePorts;
+
+struct ClockedVoice : EngineGraph<ClockedVoicePorts>
+{
+  AudioOut *audioOut = createAudioOut("audioOut");
+  Clock *clock = addNode(new Clock());
+  Voice *voice = addNode(new Voice());
+
+  ClockedVoice()
+  {
+    connect(clock->gateOut, voice->gateIn);
+    connect(voice->audioOut, audioOut);
+  }
+};
+
+static void testSilentGraphKeepsClocking()
+{
+  ClockedVoice graph;
+  float block[BLOCK_SIZE];
+  float *outBlocks[] = {block};
+  size_t numPulses = 0;
+  bool wasSounding = false;
+  for (size_t frame = 0; frame < NUM_PERIODS * CLOCK_PERIOD; frame += BLOCK_SIZE)
+  {
+    graph.doProcessBlock({SAMPLE_RATE, 1.f / SAMPLE_RATE}, BLOCK_SIZE, NULL, outBlocks);
+    bool isSounding = block[0] > 0.5f;
+    numPulses += isSounding && !wasSounding ? 1 : 0;
+    wasSounding = isSounding;
+  }
+
+  check(numPulses == NUM_PERIODS, "graph: every clock pulse sounds through the silent gaps");
+}
+
+int main(int argc, char **argv)
+{
+  testSilentGraphKeepsClocking();
+  return result();
+}
@@ -0,0 +1,65 @@
+#include <math.h>
+#include "../src/core/dsp/Exp2.hpp"
+#include "Test.hpp"
+
+/**
+ * Exp2 Tests
+ * ==========
+ * `fastExp2()` against `exp2()` in double precision, over every exponent whose
+ * result is a normal float, at 4096 points per octave plus both ends of the
+ * polynomial's range.
+ */
+
+using namespace phnq;
+using namespace phnq::test;
+
+const double EXP2_MAX_RELATIVE_ERROR = 3.6e-6; // As documented on `fastExp2()`.
+const int POINTS_PER_OCTAVE = 4096;
+
+static double relativeError(float x)
+{
+  double exact = exp2((double)x);
+  return fabs((double)fastExp2(x) - exact) / exact;
+}
+
+static void testRelativeError()
+{
+  double maxError = 0.;
+  for (int i = -126 * POINTS_PER_OCTAVE; i < 127 * POINTS_PER_OCTAVE; i++)
+  {
+    float x = (float)i / POINTS_PER_OCTAVE;
+    double error = relativeError(x);
+    maxError = error > maxError ? error : maxError;
+
+    // Either side of where the split rounds to the next integer.
+    float half = (float)(i / POINTS_PER_OCTAVE) + 0.5f;
+    error = fmax(relativeError(nextafterf(half, -INFINITY)), relativeError(half));
+    maxError = error > maxError ? error : maxError;
+  }
+
+  printf("max relative error %g\n", maxError);
+  check(maxError < EXP2_MAX_RELATIVE_ERROR, "fastExp2: relative error within the documented bound");
+}
+
+static void testWholeOctaves()
+{
+  bool isExact = true;
+  for (int octave = -126; octave <= 127; octave++)
+  {
+    isExact &= fastExp2((float)octave) == ldexpf(1.f, octave);
+  }
+  check(isExact, "fastExp2: whole octaves are exact");
+}
+
+static void testClamp()
+{
+  check(fastExp2(1000.f) == ldexpf(1.f, 127) && fastExp2(-1000.f) == ldexpf(1.f, -126), "fastExp2: out-of-range results clamp to the normal range");
+}
+
+int main(int argc, char **argv)
+{
+  testRelativeError();
+  testWholeOctaves();
+  testClamp();
+  return result();
+}
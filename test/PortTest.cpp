@@ -0,0 +1,71 @@
+#include "../src/core2/engine/Engine.hpp"
+#include "Test.hpp"
+
+/**
+ * Port Tests
+ * ==========
+ * Scheduled changes on input ports: however many pile up before a block, the
+ * port must end on the newest value.
+ */
+
+using namespace phnq::engine;
+using namespace phnq::test;
+
+const size_t BLOCK_SIZE = 48;
+
+struct GateEngine : Engine
+{
+  GateIn *gateIn = createGateIn("gateIn");
+  CVIn *cvIn = createCVIn("cvIn");
+  AudioOut *audioOut = createAudioOut("audioOut");
+
+  void processBlock(FrameInfo frameInfo, size_t numFrames) override
+  {
+    std::fill(audioOut->getBlock(), audioOut->getBlock() + numFrames, gateIn->getValue() ? 1.f : 0.f);
+  }
+};
+
+static void processBlock(GateEngine &engine)
+{
+  float block[BLOCK_SIZE];
+  float *outBlocks[] = {block};
+  engine.doProcessBlock({48000.f, 1.f / 48000.f}, BLOCK_SIZE, NULL, outBlocks);
+}
+
+static void testOverflowKeepsNewestValue()
+{
+  GateEngine engine;
+  engine.gateIn->setDelay(1);
+  engine.cvIn->setDelay(1);
+  for (size_t i = 0; i <= 2 * PORT_EVENT_CAPACITY; i++)
+  {
+    engine.gateIn->setValue(i % 2 == 0);
+    engine.cvIn->setValue((float)i / 100.f);
+  }
+  processBlock(engine);
+  check(engine.gateIn->getValue() == true, "overflow: delayed gate ends on the newest value");
+  check(engine.cvIn->getValue() == 2 * PORT_EVENT_CAPACITY / 100.f, "overflow: delayed CV ends on the newest value");
+
+  for (size_t i = 0; i <= 2 * PORT_EVENT_CAPACITY; i++)
+  {
+    engine.gateIn->scheduleValue(i % 2 == 1, i);
+  }
+  processBlock(engine);
+  check(engine.gateIn->getValue() == false, "overflow: scheduled gate-off isn't lost");
+}
+
+static void testSetValueQueuesBehindPendingChanges()
+{
+  GateEngine engine;
+  engine.gateIn->scheduleValue(true, 0);
+  engine.gateIn->setValue(false);
+  processBlock(engine);
+  check(engine.gateIn->getValue() == false, "setValue: lands after changes already scheduled");
+}
+
+int main(int argc, char **argv)
+{
+  testOverflowKeepsNewestValue();
+  testSetValueQueuesBehindPendingChanges();
+  return result();
+}
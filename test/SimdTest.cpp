@@ -0,0 +1,186 @@
+#include <stdlib.h>
+#include <string.h>
+#include "../src/core/simd/Simd.hpp"
+#include "Test.hpp"
+
+/**
+ * SIMD Tests
+ * ==========
+ * Every `Float4` and `Float8` operation against the same expression on each lane
+ * as a plain float, compared bit for bit. Inputs mix signed zeros, integers,
+ * halves (where `floor()` and `fastExp2()` split) and random values, so they hit
+ * the cases where vector instructions could disagree with the scalar
+ * expressions. The test is built on the scalar backend too (see mk/test.mk).
+ */
+
+using namespace phnq;
+using namespace phnq::test;
+
+const size_t NUM_ROUNDS = 100000;
+
+static float randomInput()
+{
+  switch (rand() % 6)
+  {
+  case 0:
+    return rand() % 2 ? 0.f : -0.f;
+  case 1:
+    return (float)(rand() % 17 - 8);
+  case 2:
+    return (float)(rand() % 17 - 8) + 0.5f;
+  default:
+    return (float)(rand() % 2000001 - 1000000) / 100000.f;
+  }
+}
+
+static uint32_t bits(float value)
+{
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+static bool isSame(float a, float b)
+{
+  return bits(a) == bits(b);
+}
+
+static float mask(bool condition)
+{
+  uint32_t bits = condition ? 0xFFFFFFFFu : 0u;
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+/**
+ * @brief Compares one vector operation to its lane-wise expression, tallying
+ * mismatches under the operation's name.
+ */
+template <class TVector, size_t NumLanes>
+struct LaneChecker
+{
+  float a[NumLanes], b[NumLanes], c[NumLanes], out[NumLanes];
+  bool matches = true;
+
+  void randomize()
+  {
+    for (size_t i = 0; i < NumLanes; i++)
+    {
+      a[i] = randomInput();
+      b[i] = randomInput();
+      c[i] = mask(rand() % 2);
+    }
+  }
+
+  template <class TVectorOp, class TLaneOp>
+  void expect(TVectorOp vectorOp, TLaneOp laneOp)
+  {
+    vectorOp(TVector::load(a), TVector::load(b), TVector::load(c)).store(out);
+    for (size_t i = 0; i < NumLanes; i++)
+    {
+      matches &= isSame(out[i], laneOp(a[i], b[i], c[i]));
+    }
+  }
+};
+
+template <class TVector, size_t NumLanes>
+static void testLanesMatchScalar(const char *description)
+{
+  typedef TVector V;
+  LaneChecker<V, NumLanes> checker;
+  bool sumMatches = true;
+  bool anyMatches = true;
+  for (size_t round = 0; round < NUM_ROUNDS; round++)
+  {
+    checker.randomize();
+    checker.expect([](V a, V b, V c)
+                   { return a + b; }, [](float a, float b, float c)
+                   { return a + b; });
+    checker.expect([](V a, V b, V c)
+                   { return a - b; }, [](float a, float b, float c)
+                   { return a - b; });
+    checker.expect([](V a, V b, V c)
+                   { return a * b; }, [](float a, float b, float c)
+                   { return a * b; });
+    checker.expect([](V a, V b, V c)
+                   { return a / b; }, [](float a, float b, float c)
+                   { return a / b; });
+    checker.expect([](V a, V b, V c)
+                   { return -a; }, [](float a, float b, float c)
+                   { return -a; });
+    checker.expect([](V a, V b, V c)
+                   { return a < b; }, [](float a, float b, float c)
+                   { return mask(a < b); });
+    checker.expect([](V a, V b, V c)
+                   { return a <= b; }, [](float a, float b, float c)
+                   { return mask(a <= b); });
+    checker.expect([](V a, V b, V c)
+                   { return a > b; }, [](float a, float b, float c)
+                   { return mask(a > b); });
+    checker.expect([](V a, V b, V c)
+                   { return a >= b; }, [](float a, float b, float c)
+                   { return mask(a >= b); });
+    checker.expect([](V a, V b, V c)
+                   { return simd::min(a, b); }, [](float a, float b, float c)
+                   { return a < b ? a : b; });
+    checker.expect([](V a, V b, V c)
+                   { return simd::max(a, b); }, [](float a, float b, float c)
+                   { return a > b ? a : b; });
+    checker.expect([](V a, V b, V c)
+                   { return simd::abs(a); }, [](float a, float b, float c)
+                   { return fabsf(a); });
+    checker.expect([](V a, V b, V c)
+                   { return simd::floor(a); }, [](float a, float b, float c)
+                   { return floorf(a); });
+    checker.expect([](V a, V b, V c)
+                   { return simd::sqrt(simd::abs(a)); }, [](float a, float b, float c)
+                   { return sqrtf(fabsf(a)); });
+    checker.expect([](V a, V b, V c)
+                   { return simd::select(c, a, b); }, [](float a, float b, float c)
+                   { return bits(c) ? a : b; });
+    checker.expect([](V a, V b, V c)
+                   { return c & a; }, [](float a, float b, float c)
+                   { return bits(c) ? a : 0.f; });
+    checker.expect([](V a, V b, V c)
+                   { return c | (a < b); }, [](float a, float b, float c)
+                   { return mask(bits(c) || a < b); });
+    checker.expect([](V a, V b, V c)
+                   { return simd::andNot(c, a); }, [](float a, float b, float c)
+                   { return bits(c) ? 0.f : a; });
+    checker.expect([](V a, V b, V c)
+                   { return simd::clamp(a, V(-1.f), V(1.f)); }, [](float a, float b, float c)
+                   { return fminf(fmaxf(a, -1.f), 1.f); });
+    checker.expect([](V a, V b, V c)
+                   { return simd::fastExp2(a); }, [](float a, float b, float c)
+                   { return phnq::fastExp2(a); });
+
+    // Lanes 0+2 and 1+3 (and, for eight lanes, the low half plus the high first).
+    float lanes[NumLanes];
+    V::load(checker.a).store(lanes);
+    if (NumLanes == 8)
+    {
+      for (size_t i = 0; i < 4; i++)
+      {
+        lanes[i] += lanes[i + 4];
+      }
+    }
+    sumMatches &= isSame(simd::sum(V::load(checker.a)), (lanes[0] + lanes[2]) + (lanes[1] + lanes[3]));
+
+    bool anySet = false;
+    for (size_t i = 0; i < NumLanes; i++)
+    {
+      anySet |= bits(checker.c[i]) != 0;
+    }
+    anyMatches &= simd::any(V::load(checker.c)) == anySet;
+  }
+
+  check(checker.matches && sumMatches && anyMatches, description);
+}
+
+int main(int argc, char **argv)
+{
+  testLanesMatchScalar<simd::Float4, 4>("simd: Float4 lanes match scalar float bit for bit");
+  testLanesMatchScalar<simd::Float8, 8>("simd: Float8 lanes match scalar float bit for bit");
+  return result();
+}
@@ -0,0 +1,94 @@
+#include <stdlib.h>
+#include "../src/core2/engine/Engine.hpp"
+#include "../src/core2/engine/AdcDeadband.hpp"
+#include "Test.hpp"
+
+/**
+ * Sleep Tests
+ * ===========
+ * A sleeping engine fed by the Seed's scan loop must stay asleep while its ADC
+ * inputs only jitter, and wake when one really moves. The scan loop is
+ * reproduced here: readings are quantized to 16 bits and posted only when
+ * `isAdcChange()` says so.
+ */
+
+using namespace phnq::engine;
+using namespace phnq::test;
+
+const float SAMPLE_RATE = 48000.f;
+const size_t BLOCK_SIZE = 48;
+const size_t NUM_BLOCKS = 1000;
+const float ADC_LSB = 1.f / 65535.f;
+
+/**
+ * @brief Idle until something changes, so it goes to sleep after its first block.
+ */
+struct IdleEngine : Engine
+{
+  CVIn *cvIn;
+  Param *param;
+  AudioOut *audioOut;
+
+  IdleEngine()
+  {
+    cvIn = createCVIn("cvIn");
+    param = createParam("param");
+    audioOut = createAudioOut("audioOut");
+  }
+
+  void process(FrameInfo frameInfo) override
+  {
+    audioOut->setValue(0.f);
+  }
+
+  bool isIdle() override
+  {
+    return true;
+  }
+};
+
+/**
+ * @brief One pass of the scan loop followed by one audio block. `reading` is in
+ * [0, 1] and is quantized like the Seed's ADC.
+ */
+static void scanAndProcess(IdleEngine &engine, float &cvPosted, float &paramPosted, float reading)
+{
+  float value = roundf(reading / ADC_LSB) * ADC_LSB;
+  if (isAdcChange(value, cvPosted) && engine.postValue(engine.cvIn, value * 2.f - 1.f))
+  {
+    cvPosted = value;
+  }
+  if (isAdcChange(value, paramPosted) && engine.postValue(engine.param, value))
+  {
+    paramPosted = value;
+  }
+
+  float block[BLOCK_SIZE];
+  float *outBlocks[] = {block};
+  engine.doProcessBlock({SAMPLE_RATE}, BLOCK_SIZE, NULL, outBlocks);
+}
+
+static void testJitterKeepsEngineAsleep()
+{
+  IdleEngine engine;
+  float cvPosted = NAN, paramPosted = NAN;
+  for (size_t i = 0; i < NUM_BLOCKS; i++)
+  {
+    // A steady input, ±1 LSB either side of it.
+    float jitter = (float)(rand() % 3 - 1) * ADC_LSB;
+    scanAndProcess(engine, cvPosted, paramPosted, 0.5f + jitter);
+  }
+
+  SleepStats stats = engine.getSleepStats();
+  check(stats.numSleeps == 1, "jitter: engine went to sleep once");
+  check(stats.numAsleepFrames == (NUM_BLOCKS - 1) * BLOCK_SIZE, "jitter: engine stayed asleep after its first block");
+
+  scanAndProcess(engine, cvPosted, paramPosted, 0.6f);
+  check(engine.getSleepStats().numSleeps == 2, "jitter: a real change still wakes the engine");
+}
+
+int main(int argc, char **argv)
+{
+  testJitterKeepsEngineAsleep();
+  return result();
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+/**
+ * Tests
+ * =====
+ * Each `<Area>Test.cpp` is its own program: it runs its checks, prints one line
+ * per check, and exits non-zero if any failed. `make test run` builds and runs
+ * them all.
+ */
+
+#include <stdio.h>
+
+namespace phnq
+{
+  namespace test
+  {
+    inline int &numFailures()
+    {
+      static int count = 0;
+      return count;
+    }
+
+    inline void check(bool condition, const char *description)
+    {
+      printf("%s: %s\n", condition ? "pass" : "FAIL", description);
+      numFailures() += condition ? 0 : 1;
+    }
+
+    /**
+     * @brief The exit status for `main()`.
+     */
+    inline int result()
+    {
+      return numFailures() == 0 ? 0 : 1;
+    }
+  }
+}
@@ -0,0 +1,102 @@
+#include <string.h>
+#include <vector>
+#include "../src/core/dsp/VoiceBank.hpp"
+#include "Test.hpp"
+
+/**
+ * Voice Bank Tests
+ * ================
+ * A bank of 13 voices (so the last group is part-full on every backend) runs
+ * through glides, detune, shape and pulse width changes, on polyBLEP and on
+ * wavetables. Each voice must sound the same whichever lane it runs in, and
+ * the whole output must hash to what the scalar backend produces.
+ */
+
+using namespace phnq;
+using namespace phnq::test;
+
+const float SAMPLE_RATE = 48000.f;
+const float BASE_FREQUENCY = 32.7032f;
+const size_t BLOCK_SIZE = 48;
+const size_t NUM_BLOCKS = 500;
+const size_t NUM_VOICES = 13;
+
+// FNV-1a of the left then right output bits, from the scalar backend
+// (-DPHNQ_SIMD_SCALAR) on x86-64 Linux. Glide coefficients come from `powf()`
+// and wavetables from `sin()`, so another libm may round differently.
+const uint32_t POLYBLEP_CHECKSUM = 0xa2d7d374;
+const uint32_t WAVETABLE_CHECKSUM = 0x05de31c2;
+
+static float voiceNote(size_t voice, size_t block)
+{
+  return (float)(voice * 7 % 24) / 120.f + (block >= NUM_BLOCKS / 2 ? 0.25f : 0.f) - 0.1f;
+}
+
+/**
+ * @brief Play `numVoices` voices from `firstVoice` on as a bank's first voices,
+ * mixing into `left` and `right` (`NUM_BLOCKS * BLOCK_SIZE` frames each).
+ */
+static void render(size_t firstVoice, size_t numVoices, bool wavetable, float *left, float *right)
+{
+  VoiceBank bank;
+  bank.init(SAMPLE_RATE, BASE_FREQUENCY);
+  bank.setWavetable(wavetable);
+  bank.setGlideTime(0.05f);
+  for (size_t block = 0; block < NUM_BLOCKS; block++)
+  {
+    for (size_t voice = 0; voice < numVoices; voice++)
+    {
+      bank.setNote(voice, voiceNote(firstVoice + voice, block));
+    }
+    bank.setDetune((float)(block % 100) / 10000.f);
+    bank.setShape((float)(block / 50 % 5) / 4.f);
+    bank.setPulseWidth(0.2f + (float)(block % 7) / 10.f);
+    bank.process(numVoices, &left[block * BLOCK_SIZE], &right[block * BLOCK_SIZE], BLOCK_SIZE, NULL, NULL);
+  }
+}
+
+static uint32_t checksum(const std::vector<float> &left, const std::vector<float> &right)
+{
+  uint32_t hash = 2166136261u;
+  for (const std::vector<float> *channel : {&left, &right})
+  {
+    for (float sample : *channel)
+    {
+      uint32_t bits;
+      memcpy(&bits, &sample, sizeof(bits));
+      for (size_t byte = 0; byte < 4; byte++)
+      {
+        hash = (hash ^ ((bits >> (byte * 8)) & 0xFF)) * 16777619u;
+      }
+    }
+  }
+  return hash;
+}
+
+static void testVoiceBank(bool wavetable, uint32_t expectedChecksum)
+{
+  const size_t numFrames = NUM_BLOCKS * BLOCK_SIZE;
+  std::vector<float> left(numFrames), right(numFrames);
+  render(0, NUM_VOICES, wavetable, left.data(), right.data());
+
+  // The bank adds voices in order, so each alone in lane 0 adds up to the same.
+  std::vector<float> voiceLeft(numFrames), voiceRight(numFrames);
+  for (size_t voice = 0; voice < NUM_VOICES; voice++)
+  {
+    render(voice, 1, wavetable, voiceLeft.data(), voiceRight.data());
+  }
+  bool lanesMatch = memcmp(left.data(), voiceLeft.data(), numFrames * sizeof(float)) == 0 &&
+                    memcmp(right.data(), voiceRight.data(), numFrames * sizeof(float)) == 0;
+
+  uint32_t sum = checksum(left, right);
+  printf("%s checksum %08x\n", wavetable ? "wavetable" : "polyBLEP", sum);
+  check(lanesMatch, wavetable ? "voice bank: wavetable voices sound the same in every lane" : "voice bank: polyBLEP voices sound the same in every lane");
+  check(sum == expectedChecksum, wavetable ? "voice bank: wavetable output matches the scalar backend" : "voice bank: polyBLEP output matches the scalar backend");
+}
+
+int main(int argc, char **argv)
+{
+  testVoiceBank(false, POLYBLEP_CHECKSUM);
+  testVoiceBank(true, WAVETABLE_CHECKSUM);
+  return result();
+}
@@ -0,0 +1,124 @@
+#include <stdlib.h>
+#include <new>
+#include "../src/core2/host/WorkStealingScheduler.hpp"
+#include "Test.hpp"
+
+/**
+ * Work-Stealing Scheduler Tests
+ * =============================
+ * A fan-out/fan-in graph (five branches of two nodes into a mixer and an
+ * output) run for many blocks on several threads, with random delays inside
+ * nodes so helpers wake and steal at awkward moments. Every node must run once
+ * per block, after the nodes it depends on, and running blocks must not
+ * allocate.
+ */
+
+using namespace phnq::test;
+
+const size_t NUM_BRANCHES = 5;
+const size_t NUM_NODES = 2 * NUM_BRANCHES + 2;
+const size_t NUM_BLOCKS = 5000;
+
+static std::atomic<size_t> numAllocations(0);
+
+void *operator new(size_t size)
+{
+  numAllocations++;
+  void *memory = malloc(size);
+  if (!memory)
+  {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+
+void operator delete(void *memory) noexcept
+{
+  free(memory);
+}
+
+/**
+ * @brief Records the block each node last ran in, and counts ordering errors.
+ */
+struct RecordingRunner : phnq::engine::NodeRunner
+{
+  const std::vector<std::vector<size_t>> &dependents;
+  std::atomic<size_t> numRuns[NUM_NODES];
+  std::atomic<size_t> doneBlock[NUM_NODES];
+  std::atomic<size_t> numOrderErrors;
+  size_t block = 0;
+
+  RecordingRunner(const std::vector<std::vector<size_t>> &dependents) : dependents(dependents), numOrderErrors(0)
+  {
+    for (size_t i = 0; i < NUM_NODES; i++)
+    {
+      numRuns[i] = 0;
+      doneBlock[i] = SIZE_MAX;
+    }
+  }
+
+  void runNode(size_t index) override
+  {
+    if (rand() % 7 == 0)
+    {
+      std::this_thread::sleep_for(std::chrono::microseconds(rand() % 50));
+    }
+    for (size_t source = 0; source < NUM_NODES; source++)
+    {
+      for (size_t target : dependents[source])
+      {
+        if (target == index && doneBlock[source] != block)
+        {
+          numOrderErrors++;
+        }
+      }
+    }
+    numRuns[index]++;
+    doneBlock[index] = block;
+  }
+};
+
+static void testFanOutFanIn(size_t numThreads)
+{
+  // Branch i is nodes i and NUM_BRANCHES + i, into the mixer, into the output.
+  std::vector<std::vector<size_t>> dependents(NUM_NODES);
+  size_t mixer = 2 * NUM_BRANCHES;
+  for (size_t i = 0; i < NUM_BRANCHES; i++)
+  {
+    dependents[i].push_back(NUM_BRANCHES + i);
+    dependents[NUM_BRANCHES + i].push_back(mixer);
+  }
+  dependents[mixer].push_back(mixer + 1);
+
+  phnq::host::WorkStealingScheduler scheduler(numThreads);
+  scheduler.setDependencies(dependents);
+  RecordingRunner runner(dependents);
+
+  bool ranOncePerBlock = true;
+  size_t numBlockAllocations = 0;
+  for (size_t block = 0; block < NUM_BLOCKS && ranOncePerBlock; block++)
+  {
+    runner.block = block;
+    size_t allocationsBefore = numAllocations;
+    scheduler.runNodes(runner);
+    numBlockAllocations += numAllocations - allocationsBefore;
+    for (size_t i = 0; i < NUM_NODES; i++)
+    {
+      ranOncePerBlock &= runner.numRuns[i] == block + 1;
+    }
+  }
+
+  printf("%lu threads\n", (unsigned long)numThreads);
+  check(ranOncePerBlock, "scheduler: every node runs once per block");
+  check(runner.numOrderErrors == 0, "scheduler: nodes run after the nodes they depend on");
+  check(numBlockAllocations == 0, "scheduler: running blocks doesn't allocate");
+}
+
+int main(int argc, char **argv)
+{
+  for (size_t numThreads : {1, 2, 4, 8})
+  {
+    testFanOutFanIn(numThreads);
+  }
+  return result();
+}